@@ -1,6 +1,7 @@
 #include "dump_metadatas.h"
 #include "globals.h"
 #include "io.h"
+#include "metadata.h"
 #include "sw.h"
 #include "password_ui_flows.h"
 
@@ -12,7 +13,7 @@ int dump_metadatas() {
         return 0;
     }
 
-    size_t remaining_bytes_count = sizeof(N_storage.metadatas) - app_state.bytes_transferred;
+    size_t remaining_bytes_count = MAX_METADATAS - app_state.bytes_transferred;
     size_t payload_size;
 
     if (remaining_bytes_count < MAX_PAYLOAD_SIZE) {
@@ -26,7 +27,7 @@ int dump_metadatas() {
     }
 
     os_memcpy(&G_io_apdu_buffer[TRANSFER_PAYLOAD_OFFSET],
-              (const void*) N_storage.metadatas + app_state.bytes_transferred,
+              (const void*) METADATA_PTR(app_state.bytes_transferred),
               payload_size);
 
     app_state.bytes_transferred += payload_size;
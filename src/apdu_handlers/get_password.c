@@ -0,0 +1,57 @@
+#include "get_password.h"
+#include "globals.h"
+#include "io.h"
+#include "sw.h"
+#include "metadata.h"
+#include "password_typing.h"
+#include "password_ui_flows.h"
+
+/* Takes an entry index (2 bytes, big endian) and returns its password once the user approved */
+int get_password(uint8_t p1, uint8_t p2, const buf_t *input) {
+    if (p1 != 0 || p2 != 0) {
+        return send_sw(SW_WRONG_P1P2);
+    }
+    if (input->size != 2) {
+        return send_sw(SW_WRONG_DATA_LENGTH);
+    }
+    size_t offset = get_metadata(U2BE(input->bytes, 0));
+    if (offset == METADATA_END) {
+        return send_sw(SW_ENTRY_NOT_FOUND);
+    }
+
+    char nickname[MAX_METANAME + 1];
+    uint8_t nickname_len = get_metadata_nickname(offset, nickname);
+    if (app_state.user_approval == false) {
+        app_state.approved_offset = offset;
+        strcpy(app_state.approved_nickname, nickname);
+        message_pair_t msg = {"Export password", app_state.approved_nickname};
+        ui_request_user_approval(&msg);
+        return 0;
+    }
+    app_state.user_approval = false;
+    // the usage flush may have moved the entries while the prompt was open: the index must
+    // still lead to the entry the user approved
+    if (offset != app_state.approved_offset ||
+        strcmp(nickname, app_state.approved_nickname) != 0) {
+        ui_idle();
+        return send_sw(SW_ENTRY_NOT_FOUND);
+    }
+
+    uint8_t enabledSets = METADATA_SETS(offset);
+    if (enabledSets == 0) {
+        enabledSets = ALL_SETS;
+    }
+    // generate_password() terminates the password with a '\0'
+    uint8_t out_buffer[PASSWORD_LENGTH + 1];
+    type_password((uint8_t *) nickname,
+                  nickname_len,
+                  out_buffer,
+                  enabledSets,
+                  (const uint8_t *) PIC(DEFAULT_MIN_SET),
+                  PASSWORD_LENGTH);
+    ui_idle();
+    const buf_t response = {.bytes = out_buffer, .size = PASSWORD_LENGTH};
+    int ret = send(&response, SW_OK);
+    os_memset(out_buffer, 0, sizeof(out_buffer));
+    return ret;
+}
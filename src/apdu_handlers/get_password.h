@@ -0,0 +1,11 @@
+#ifndef __GET_PASSWORD_H__
+#define __GET_PASSWORD_H__
+
+#include "stdint.h"
+#include "types.h"
+
+#define PASSWORD_LENGTH 20
+
+int get_password(uint8_t p1, uint8_t p2, const buf_t *input);
+
+#endif
@@ -0,0 +1,38 @@
+#include "get_store_stats.h"
+#include "globals.h"
+#include "io.h"
+#include "sw.h"
+#include "store_stats.h"
+
+static size_t put_be(uint8_t *buffer, uint32_t value, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = value >> 8 * (len - 1 - i);
+    }
+    return len;
+}
+
+/*
+ * Returns, big endian: the entries count (2 bytes), the bytes of erased records (4), the free
+ * bytes (4), the fragmentation in per mille (2), then the compactions (4) and the bytes written
+ * (4) since the store was created
+ */
+int get_store_stats(uint8_t p1, uint8_t p2, const buf_t *input) {
+    if (p1 != 0 || p2 != 0) {
+        return send_sw(SW_WRONG_P1P2);
+    }
+
+    store_stats_t stats;
+    store_stats_get(&stats);
+
+    uint8_t *response = G_io_apdu_buffer;
+    size_t offset = 0;
+    offset += put_be(response + offset, stats.entries, 2);
+    offset += put_be(response + offset, stats.erased_bytes, 4);
+    offset += put_be(response + offset, stats.free_bytes, 4);
+    offset += put_be(response + offset, stats.fragmentation, 2);
+    offset += put_be(response + offset, stats.compactions, 4);
+    offset += put_be(response + offset, stats.bytes_written, 4);
+
+    const buf_t buf = {.bytes = response, .size = offset};
+    return send(&buf, SW_OK);
+}
@@ -0,0 +1,9 @@
+#ifndef __GET_STORE_STATS_H__
+#define __GET_STORE_STATS_H__
+
+#include "stdint.h"
+#include "types.h"
+
+int get_store_stats(uint8_t p1, uint8_t p2, const buf_t *input);
+
+#endif
@@ -4,6 +4,8 @@
 #include "sw.h"
 #include "metadata.h"
 #include "password_ui_flows.h"
+#include "entry_index.h"
+#include "entry_usage.h"
 
 int load_metadatas(uint8_t p1, uint8_t p2, const buf_t *input) {
     if ((p1 != 0 && p1 != P1_LAST_CHUNK) || p2 != 0) {
@@ -16,23 +18,38 @@ int load_metadatas(uint8_t p1, uint8_t p2, const buf_t *input) {
         return 0;
     }
 
-    if (input->size > sizeof(N_storage.metadatas) - app_state.bytes_transferred) {
+    if (input->size > MAX_METADATAS - app_state.bytes_transferred) {
         return send_sw(SW_WRONG_DATA_LENGTH);
     }
 
-    nvm_write((void *) N_storage.metadatas + app_state.bytes_transferred,
-              (void *) input->bytes,
-              input->size);
+    if (app_state.bytes_transferred == 0) {
+        start_metadatas_load();
+    }
+    // the records in use are only replaced once the whole load is checked
+    error_type_t err = write_metadatas_chunk(input->bytes, input->size);
     app_state.bytes_transferred += input->size;
+    bool last_chunk = app_state.bytes_transferred >= MAX_METADATAS || p1 == P1_LAST_CHUNK;
+    if (err == OK && last_chunk) {
+        err = commit_metadatas_load();
+    }
 
-    if (app_state.bytes_transferred >= sizeof(N_storage.metadatas) || p1 == P1_LAST_CHUNK) {
+    if (err != OK || last_chunk) {
         // reset state
         app_state.user_approval = false;
         ui_idle();
-        if (compact_metadata()) {
-            return send_sw(SW_METADATAS_PARSING_ERROR);
-        }
     }
-
-    return send_sw(SW_OK);
+    if (err != OK) {
+        return send_sw(SW_METADATAS_PARSING_ERROR);
+    }
+    if (!last_chunk) {
+        return send_sw(SW_OK);
+    }
+    entry_usage_init();
+    entry_index_build();
+    // loading the same entries again leaves a single copy of each
+    uint16_t duplicates = erase_duplicate_metadatas();
+    G_io_apdu_buffer[0] = duplicates >> 8;
+    G_io_apdu_buffer[1] = duplicates & 0xFF;
+    const buf_t response = {.bytes = G_io_apdu_buffer, .size = 2};
+    return send(&response, SW_OK);
 }
\ No newline at end of file
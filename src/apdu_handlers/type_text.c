@@ -0,0 +1,32 @@
+#include "type_text.h"
+#include "globals.h"
+#include "io.h"
+#include "sw.h"
+#include "password_typing.h"
+#include "password_ui_flows.h"
+
+int type_text(uint8_t p1, uint8_t p2, const buf_t *input) {
+    if ((p1 != 0 && p1 != P1_PRESS_ENTER) || p2 != 0) {
+        return send_sw(SW_WRONG_P1P2);
+    }
+    if (input->size == 0 || input->size > MAX_TYPED_TEXT_LEN) {
+        return send_sw(SW_WRONG_DATA_LENGTH);
+    }
+    // only characters the keyboard mappings know how to type
+    for (size_t i = 0; i < input->size; i++) {
+        if (input->bytes[i] < 0x20 || input->bytes[i] > 0x7E) {
+            return send_sw(SW_WRONG_DATA);
+        }
+    }
+
+    if (app_state.user_approval == false) {
+        // the user reviews everything that is about to be typed
+        ui_request_text_approval(input->bytes, input->size, p1 == P1_PRESS_ENTER);
+        return 0;
+    }
+
+    app_state.user_approval = false;
+    type_string(input->bytes, input->size, p1 == P1_PRESS_ENTER);
+    ui_idle();
+    return send_sw(SW_OK);
+}
@@ -0,0 +1,14 @@
+#ifndef __TYPE_TEXT_H__
+#define __TYPE_TEXT_H__
+
+#include "stdint.h"
+#include "types.h"
+
+/* longest text the host may have typed in a single command */
+#define MAX_TYPED_TEXT_LEN 64
+
+#define P1_PRESS_ENTER 0x01
+
+int type_text(uint8_t p1, uint8_t p2, const buf_t *input);
+
+#endif
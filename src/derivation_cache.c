@@ -0,0 +1,81 @@
+#include "derivation_cache.h"
+
+#include "os.h"
+
+#include "globals.h"
+#include "password_typing.h"
+
+typedef struct derivation_cache_entry_s {
+    uint8_t data_len;  // 0 for an empty entry
+    uint8_t data[MAX_METANAME];
+    uint8_t seed[PASSWORD_SEED_LEN];
+} derivation_cache_entry_t;
+
+/* most recently used first */
+static derivation_cache_entry_t derivation_cache[DERIVATION_CACHE_SIZE];
+static uint16_t derivation_cache_idle_ticks;
+
+/* moves the entry at index to the front, shifting the more recent ones down */
+static void derivation_cache_promote(uint8_t index) {
+    derivation_cache_entry_t entry;
+    os_memcpy(&entry, &derivation_cache[index], sizeof(entry));
+    os_memmove(&derivation_cache[1], &derivation_cache[0], index * sizeof(entry));
+    os_memcpy(&derivation_cache[0], &entry, sizeof(entry));
+    os_memset(&entry, 0, sizeof(entry));
+}
+
+static int derivation_cache_find(const uint8_t *data, uint32_t dataSize) {
+    for (uint8_t i = 0; i < DERIVATION_CACHE_SIZE; i++) {
+        if (derivation_cache[i].data_len != 0 && derivation_cache[i].data_len == dataSize &&
+            os_memcmp(derivation_cache[i].data, data, dataSize) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool derivation_cache_get(const uint8_t *data, uint32_t dataSize, uint8_t *seed) {
+    if (!N_storage.cache_recent_passwords) {
+        return false;
+    }
+    int index = derivation_cache_find(data, dataSize);
+    if (index < 0) {
+        return false;
+    }
+    derivation_cache_promote(index);
+    os_memcpy(seed, derivation_cache[0].seed, PASSWORD_SEED_LEN);
+    derivation_cache_idle_ticks = 0;
+    return true;
+}
+
+void derivation_cache_put(const uint8_t *data, uint32_t dataSize, const uint8_t *seed) {
+    if (!N_storage.cache_recent_passwords || dataSize == 0 ||
+        dataSize > sizeof(derivation_cache[0].data)) {
+        return;
+    }
+    int index = derivation_cache_find(data, dataSize);
+    if (index < 0) {
+        // reuse the least recently used entry
+        index = DERIVATION_CACHE_SIZE - 1;
+        os_memcpy(derivation_cache[index].data, data, dataSize);
+        derivation_cache[index].data_len = dataSize;
+        os_memcpy(derivation_cache[index].seed, seed, PASSWORD_SEED_LEN);
+    }
+    derivation_cache_promote(index);
+    derivation_cache_idle_ticks = 0;
+}
+
+void derivation_cache_on_ticker(void) {
+    if (derivation_cache[0].data_len == 0) {
+        return;
+    }
+    if (++derivation_cache_idle_ticks >= DERIVATION_CACHE_TIMEOUT_TICKS ||
+        os_global_pin_is_validated() != BOLOS_UX_OK) {
+        derivation_cache_wipe();
+    }
+}
+
+void derivation_cache_wipe(void) {
+    os_memset(derivation_cache, 0, sizeof(derivation_cache));
+    derivation_cache_idle_ticks = 0;
+}
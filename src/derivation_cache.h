@@ -0,0 +1,25 @@
+#ifndef __DERIVATION_CACHE_H__
+#define __DERIVATION_CACHE_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/* number of recently used password seeds kept in RAM */
+#define DERIVATION_CACHE_SIZE 3
+
+#ifndef DERIVATION_CACHE_TIMEOUT_S
+#define DERIVATION_CACHE_TIMEOUT_S 300
+#endif
+/* ticker events (100ms) without use after which the cache is wiped */
+#define DERIVATION_CACHE_TIMEOUT_TICKS (DERIVATION_CACHE_TIMEOUT_S * 10)
+
+/*
+ * Opt-in LRU cache of the seeds derived for recently typed passwords, so that typing the
+ * same entry again skips the BIP32 derivation. Nothing is ever written to NVM.
+ */
+bool derivation_cache_get(const uint8_t *data, uint32_t dataSize, uint8_t *seed);
+void derivation_cache_put(const uint8_t *data, uint32_t dataSize, const uint8_t *seed);
+void derivation_cache_on_ticker(void);
+void derivation_cache_wipe(void);
+
+#endif
@@ -22,9 +22,13 @@
 #include "globals.h"
 #include "io.h"
 #include "sw.h"
+#include "metadata.h"
 #include "apdu_handlers/dump_metadatas.h"
 #include "apdu_handlers/load_metadatas.h"
 #include "apdu_handlers/get_app_config.h"
+#include "apdu_handlers/type_text.h"
+#include "apdu_handlers/get_password.h"
+#include "apdu_handlers/get_store_stats.h"
 #include "tests/tests.h"
 
 int dispatch() {
@@ -32,6 +36,8 @@ int dispatch() {
         return send_sw(SW_CLA_NOT_SUPPORTED);
     }
 
+    compaction_postpone();
+
     uint8_t ins = G_io_apdu_buffer[OFFSET_INS];
     if (app_state.current_command != ins) {
         app_state.current_command = ins;
@@ -50,6 +56,12 @@ int dispatch() {
             return dump_metadatas();
         case LOAD_METADATAS:
             return load_metadatas(p1, p2, &input);
+        case TYPE_TEXT:
+            return type_text(p1, p2, &input);
+        case GET_PASSWORD:
+            return get_password(p1, p2, &input);
+        case GET_STORE_STATS:
+            return get_store_stats(p1, p2, &input);
 
 #ifdef TESTING
         case RUN_TEST:
@@ -0,0 +1,110 @@
+#include "domain_trie.h"
+
+#include "os.h"
+#include "string.h"
+
+#define LABEL_END     0x80
+#define TERMINAL_NODE 0x80
+#define LONG_LENGTH   0x80
+
+/* endings replaced by a control character in the labels, must match the generator */
+static const char *const DOMAIN_TRIE_TOKENS[] = {"", ".com", ".org", ".net"};
+
+#define TRIE_BYTE(pos) (((const uint8_t *) PIC(DOMAIN_TRIE))[pos])
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/* expands the label at pos, returns the position following it */
+static uint16_t read_label(uint16_t pos, char *label, size_t *label_len) {
+    uint8_t c;
+    *label_len = 0;
+    do {
+        c = TRIE_BYTE(pos++);
+        uint8_t ch = c & ~LABEL_END;
+        if (ch < sizeof(DOMAIN_TRIE_TOKENS) / sizeof(DOMAIN_TRIE_TOKENS[0])) {
+            const char *token = (const char *) PIC(DOMAIN_TRIE_TOKENS[ch]);
+            size_t token_len = strlen(token);
+            if (*label_len + token_len <= DOMAIN_TRIE_MAX_WORD) {
+                memcpy(label + *label_len, token, token_len);
+                *label_len += token_len;
+            }
+        } else if (*label_len < DOMAIN_TRIE_MAX_WORD) {
+            label[(*label_len)++] = ch;
+        }
+    } while (!(c & LABEL_END) && pos < DOMAIN_TRIE_SIZE);
+    return pos;
+}
+
+static uint16_t read_length(uint16_t *pos) {
+    uint16_t length = TRIE_BYTE((*pos)++);
+    if (length & LONG_LENGTH) {
+        length = ((length & ~LONG_LENGTH) << 8) | TRIE_BYTE((*pos)++);
+    }
+    return length;
+}
+
+static bool append(char *completion,
+                   size_t completion_size,
+                   size_t *len,
+                   const char *s,
+                   size_t n) {
+    if (*len + n >= completion_size) {
+        return false;
+    }
+    memcpy(completion + *len, s, n);
+    *len += n;
+    completion[*len] = '\0';
+    return true;
+}
+
+bool domain_trie_complete(const char *prefix,
+                          size_t prefix_len,
+                          char *completion,
+                          size_t completion_size) {
+    char label[DOMAIN_TRIE_MAX_WORD];
+    size_t label_len;
+    size_t matched = 0;
+    size_t len = 0;
+    uint16_t pos = 0;
+
+    if (completion_size == 0) {
+        return false;
+    }
+    completion[0] = '\0';
+    while (pos < DOMAIN_TRIE_SIZE) {
+        uint8_t header = TRIE_BYTE(pos++);
+        uint8_t edges = header & ~TERMINAL_NODE;
+        if (matched == prefix_len && (header & TERMINAL_NODE) && len > 0) {
+            return true;  // the shortest word is enough
+        }
+        bool descended = false;
+        for (uint8_t i = 0; i < edges && !descended; i++) {
+            pos = read_label(pos, label, &label_len);
+            uint16_t subtree_len = read_length(&pos);
+            size_t common = prefix_len - matched < label_len ? prefix_len - matched : label_len;
+            size_t j = 0;
+            while (j < common && to_lower(prefix[matched + j]) == label[j]) {
+                j++;
+            }
+            if (j < common) {
+                pos += subtree_len;  // not this branch
+                continue;
+            }
+            matched += common;
+            // once the prefix is consumed, the labels along the first edges complete it
+            if (!append(completion, completion_size, &len, label + common, label_len - common)) {
+                return false;  // a truncated word would not be a completion
+            }
+            if (subtree_len == 0) {
+                return len > 0;
+            }
+            descended = true;
+        }
+        if (!descended) {
+            return false;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,24 @@
+#ifndef __DOMAIN_TRIE_H__
+#define __DOMAIN_TRIE_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+/* longest word of the dictionary, plus one */
+#define DOMAIN_TRIE_MAX_WORD 32
+
+/* radix tree of common domains and services, see tools/gen_domain_trie.py for the format */
+extern const uint8_t DOMAIN_TRIE[];
+extern const uint16_t DOMAIN_TRIE_SIZE;
+
+/*
+ * Writes in completion the end of the most popular dictionary word starting with prefix
+ * (ignoring case). Returns false when no word extends the prefix.
+ */
+bool domain_trie_complete(const char *prefix,
+                          size_t prefix_len,
+                          char *completion,
+                          size_t completion_size);
+
+#endif
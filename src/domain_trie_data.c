@@ -0,0 +1,73 @@
+/*
+ * Generated by tools/gen_domain_trie.py, do not edit.
+ * 90 words, 896 bytes of text in 733 bytes.
+ */
+
+#include "domain_trie.h"
+
+const uint8_t DOMAIN_TRIE[] = {
+    0x18, 0xae, 0x2a, 0x08, 0xe3, 0x0c, 0x02, 0xef, 0x07, 0x02, 0xed, 0x00,
+    0x2e, 0x75, 0xeb, 0x00, 0xe8, 0x00, 0x6f, 0x72, 0xe7, 0x00, 0x6e, 0x65,
+    0xf4, 0x00, 0x69, 0xef, 0x00, 0x66, 0xf2, 0x00, 0x64, 0xe5, 0x03, 0x81,
+    0xf6, 0x00, 0x65, 0xf5, 0x00, 0x61, 0x70, 0xf0, 0x00, 0xe7, 0x2b, 0x04,
+    0xef, 0x0e, 0x02, 0x6f, 0x67, 0x6c, 0x65, 0x81, 0x00, 0x64, 0x61, 0x64,
+    0x64, 0x79, 0x81, 0x00, 0x6d, 0x61, 0x69, 0x6c, 0x81, 0x00, 0x69, 0xf4,
+    0x0b, 0x02, 0x68, 0x75, 0x62, 0x81, 0x00, 0x6c, 0x61, 0x62, 0x81, 0x00,
+    0x61, 0x6e, 0x64, 0x69, 0x83, 0x00, 0x66, 0xe1, 0x11, 0x02, 0x63, 0x65,
+    0x62, 0x6f, 0x6f, 0x6b, 0x81, 0x00, 0x73, 0x74, 0x6d, 0x61, 0x69, 0x6c,
+    0x81, 0x00, 0xe1, 0x36, 0x07, 0x6d, 0x61, 0x7a, 0x6f, 0x6e, 0x81, 0x00,
+    0x70, 0x70, 0x6c, 0x65, 0x81, 0x00, 0x64, 0x6f, 0x62, 0x65, 0x81, 0x00,
+    0x74, 0x6c, 0x61, 0x73, 0x73, 0x69, 0x61, 0x6e, 0x81, 0x00, 0x69, 0x72,
+    0x62, 0x6e, 0x62, 0x81, 0x00, 0x77, 0x73, 0x2e, 0x61, 0x6d, 0x61, 0x7a,
+    0x6f, 0x6e, 0x81, 0x00, 0x7a, 0x75, 0x72, 0x65, 0x81, 0x00, 0xed, 0x1a,
+    0x03, 0x69, 0x63, 0x72, 0x6f, 0x73, 0x6f, 0x66, 0x74, 0x81, 0x00, 0x6f,
+    0x7a, 0x69, 0x6c, 0x6c, 0x61, 0x82, 0x00, 0x65, 0x64, 0x69, 0x75, 0x6d,
+    0x81, 0x00, 0xef, 0x1b, 0x04, 0x75, 0x74, 0x6c, 0x6f, 0x6f, 0x6b, 0x81,
+    0x00, 0x76, 0x68, 0x81, 0x00, 0x66, 0x66, 0x69, 0x63, 0x65, 0x81, 0x00,
+    0x72, 0x69, 0x67, 0x69, 0x6e, 0x81, 0x00, 0xec, 0x17, 0x02, 0xe9, 0x0d,
+    0x02, 0x76, 0x65, 0x81, 0x00, 0x6e, 0x6b, 0x65, 0x64, 0x69, 0x6e, 0x81,
+    0x00, 0x65, 0x64, 0x67, 0x65, 0x72, 0x81, 0x00, 0xe8, 0x10, 0x02, 0x6f,
+    0x74, 0x6d, 0x61, 0x69, 0x6c, 0x81, 0x00, 0x65, 0x72, 0x6f, 0x6b, 0x75,
+    0x81, 0x00, 0xf9, 0x0f, 0x02, 0x61, 0x68, 0x6f, 0x6f, 0x81, 0x00, 0x6f,
+    0x75, 0x74, 0x75, 0x62, 0x65, 0x81, 0x00, 0xf4, 0x2b, 0x03, 0x77, 0x69,
+    0xf4, 0x0c, 0x02, 0x74, 0x65, 0x72, 0x81, 0x00, 0x63, 0x68, 0x2e, 0x74,
+    0xf6, 0x00, 0x65, 0x6c, 0x65, 0x67, 0x72, 0x61, 0x6d, 0x82, 0x00, 0xf5,
+    0x0f, 0x02, 0x6d, 0x62, 0x6c, 0x72, 0x81, 0x00, 0x74, 0x61, 0x6e, 0x6f,
+    0x74, 0x61, 0x81, 0x00, 0xe9, 0x12, 0x02, 0x6e, 0x73, 0x74, 0x61, 0x67,
+    0x72, 0x61, 0x6d, 0x81, 0x00, 0x63, 0x6c, 0x6f, 0x75, 0x64, 0x81, 0x00,
+    0xee, 0x26, 0x05, 0x65, 0x74, 0x66, 0x6c, 0x69, 0x78, 0x81, 0x00, 0x61,
+    0x6d, 0x65, 0x63, 0x68, 0x65, 0x61, 0x70, 0x81, 0x00, 0x70, 0x6d, 0x6a,
+    0x73, 0x81, 0x00, 0x32, 0x36, 0x81, 0x00, 0x69, 0x6e, 0x74, 0x65, 0x6e,
+    0x64, 0x6f, 0x81, 0x00, 0xf0, 0x34, 0x05, 0x61, 0x79, 0x70, 0x61, 0x6c,
+    0x81, 0x00, 0x72, 0x6f, 0x74, 0x6f, 0xee, 0x0b, 0x02, 0x6d, 0x61, 0x69,
+    0x6c, 0x81, 0x00, 0x2e, 0x6d, 0xe5, 0x00, 0x79, 0x70, 0x69, 0x82, 0x00,
+    0x69, 0x6e, 0x74, 0x65, 0x72, 0x65, 0x73, 0x74, 0x81, 0x00, 0x6c, 0x61,
+    0x79, 0x73, 0x74, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x81, 0x00, 0xe4, 0x31,
+    0x04, 0x72, 0x6f, 0x70, 0x62, 0x6f, 0x78, 0x81, 0x00, 0xe9, 0x14, 0x02,
+    0x73, 0x63, 0x6f, 0x72, 0x64, 0x81, 0x00, 0x67, 0x69, 0x74, 0x61, 0x6c,
+    0x6f, 0x63, 0x65, 0x61, 0x6e, 0x81, 0x00, 0x6f, 0x63, 0x6b, 0x65, 0x72,
+    0x81, 0x00, 0x75, 0x63, 0x6b, 0x64, 0x75, 0x63, 0x6b, 0x67, 0x6f, 0x81,
+    0x00, 0x72, 0xe5, 0x0e, 0x02, 0x64, 0x64, 0x69, 0x74, 0x81, 0x00, 0x76,
+    0x6f, 0x6c, 0x75, 0x74, 0x81, 0x00, 0xf7, 0x24, 0x03, 0xe9, 0x0e, 0x02,
+    0x6b, 0x69, 0x70, 0x65, 0x64, 0x69, 0x61, 0x82, 0x00, 0x73, 0x65, 0x81,
+    0x00, 0x68, 0x61, 0x74, 0x73, 0x61, 0x70, 0x70, 0x81, 0x00, 0x6f, 0x72,
+    0x64, 0x70, 0x72, 0x65, 0x73, 0x73, 0x81, 0x00, 0xe2, 0x2a, 0x02, 0xe9,
+    0x1f, 0x02, 0xf4, 0x10, 0x02, 0x62, 0x75, 0x63, 0x6b, 0x65, 0x74, 0x82,
+    0x00, 0x73, 0x74, 0x61, 0x6d, 0x70, 0x83, 0x00, 0xee, 0x0a, 0x02, 0x61,
+    0x6e, 0x63, 0x65, 0x81, 0x00, 0x67, 0x81, 0x00, 0x6f, 0x6f, 0x6b, 0x69,
+    0x6e, 0x67, 0x81, 0x00, 0xf3, 0x46, 0x06, 0xf4, 0x20, 0x03, 0x61, 0x63,
+    0x6b, 0x6f, 0x76, 0x65, 0x72, 0x66, 0x6c, 0x6f, 0x77, 0x81, 0x00, 0x65,
+    0x61, 0x6d, 0x70, 0x6f, 0x77, 0x65, 0x72, 0x65, 0x64, 0x81, 0x00, 0x72,
+    0x69, 0x70, 0x65, 0x81, 0x00, 0x6c, 0x61, 0x63, 0x6b, 0x81, 0x00, 0x70,
+    0x6f, 0x74, 0x69, 0x66, 0x79, 0x81, 0x00, 0x69, 0x67, 0x6e, 0x61, 0x6c,
+    0x82, 0x00, 0x68, 0x6f, 0x70, 0x69, 0x66, 0x79, 0x81, 0x00, 0x6b, 0x79,
+    0x70, 0x65, 0x81, 0x00, 0xe5, 0x10, 0x02, 0x62, 0x61, 0x79, 0x81, 0x00,
+    0x70, 0x69, 0x63, 0x67, 0x61, 0x6d, 0x65, 0x73, 0x81, 0x00, 0x7a, 0x6f,
+    0x6f, 0x6d, 0x2e, 0x75, 0xf3, 0x00, 0xe3, 0x15, 0x02, 0x6c, 0x6f, 0x75,
+    0x64, 0x66, 0x6c, 0x61, 0x72, 0x65, 0x81, 0x00, 0x6f, 0x69, 0x6e, 0x62,
+    0x61, 0x73, 0x65, 0x81, 0x00, 0x75, 0x62, 0x65, 0x72, 0x81, 0x00, 0x6b,
+    0x72, 0x61, 0x6b, 0x65, 0x6e, 0x81, 0x00, 0x78, 0x62, 0x6f, 0x78, 0x81,
+    0x00,
+};
+
+const uint16_t DOMAIN_TRIE_SIZE = sizeof(DOMAIN_TRIE);
@@ -0,0 +1,370 @@
+#include "entry_index.h"
+
+#include "os.h"
+
+#include "globals.h"
+#include "entry_usage.h"
+
+typedef struct entry_index_s {
+    bool available;
+    uint16_t generation;  // changed by every update
+    uint16_t count;
+    uint16_t offsets[MAX_INDEXED_ENTRIES];  // ascending, as the log
+    uint16_t fingerprints[MAX_INDEXED_ENTRIES];  // of the charsets and nickname of each entry
+    // entry numbers (positions in offsets) ordered by nickname, by last use, and by group then
+    // nickname
+    uint16_t sorted[MAX_INDEXED_ENTRIES];
+    uint16_t recent[MAX_INDEXED_ENTRIES];
+    uint16_t grouped[MAX_INDEXED_ENTRIES];
+    uint16_t group_counts[METADATA_GROUPS];
+} entry_index_t;
+
+typedef int (*compare_entries_t)(uint16_t a, uint16_t b);
+
+static entry_index_t entry_index;
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static int compare_nicknames(uint16_t nth_a, uint16_t nth_b) {
+    uint32_t a = entry_index.offsets[nth_a];
+    uint32_t b = entry_index.offsets[nth_b];
+    char nickname_a[MAX_METANAME + 1];
+    char nickname_b[MAX_METANAME + 1];
+    size_t len_a = get_metadata_nickname(a, nickname_a);
+    size_t len_b = get_metadata_nickname(b, nickname_b);
+    for (size_t i = 0; i < len_a && i < len_b; i++) {
+        char c_a = to_lower(nickname_a[i]);
+        char c_b = to_lower(nickname_b[i]);
+        if (c_a != c_b) {
+            return c_a - c_b;
+        }
+    }
+    return len_a - len_b;
+}
+
+/* FNV-1a of the charsets and the unpacked nickname, folded to 16 bits */
+static uint16_t fingerprint(uint8_t sets, const char *nickname, uint8_t len) {
+    uint32_t hash = (2166136261u ^ sets) * 16777619u;
+    for (uint8_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t) nickname[i]) * 16777619u;
+    }
+    return (hash >> 16) ^ (hash & 0xFFFF);
+}
+
+static bool same_entry(uint32_t offset, uint8_t sets, const char *nickname, uint8_t len) {
+    char stored[MAX_METANAME + 1];
+    return METADATA_SETS(offset) == sets && get_metadata_nickname(offset, stored) == len &&
+           os_memcmp(stored, nickname, len) == 0;
+}
+
+/* favourites first, then the most recently used */
+static int compare_last_uses(uint16_t nth_a, uint16_t nth_b) {
+    uint32_t a = entry_index.offsets[nth_a];
+    uint32_t b = entry_index.offsets[nth_b];
+    bool favourite_a = entry_usage_is_favourite(a);
+    if (favourite_a != entry_usage_is_favourite(b)) {
+        return favourite_a ? -1 : 1;
+    }
+    return (int) entry_usage_last_used(b) - (int) entry_usage_last_used(a);
+}
+
+static int compare_groups(uint16_t nth_a, uint16_t nth_b) {
+    int group_a = METADATA_GROUP(entry_index.offsets[nth_a]);
+    int group_b = METADATA_GROUP(entry_index.offsets[nth_b]);
+    if (group_a != group_b) {
+        return group_a - group_b;
+    }
+    return compare_nicknames(nth_a, nth_b);
+}
+
+/* inserts the nth entry in one of the permutations, after the entries comparing equal */
+static void insert_entry(uint16_t *order,
+                         uint16_t order_len,
+                         compare_entries_t compare,
+                         uint16_t nth) {
+    uint16_t low = 0;
+    uint16_t high = order_len;
+    while (low < high) {
+        uint16_t middle = (low + high) / 2;
+        if (compare(order[middle], nth) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    os_memmove(&order[low + 1], &order[low], (order_len - low) * sizeof(order[0]));
+    order[low] = nth;
+}
+
+/* removes the nth entry from one of the permutations, which is one entry shorter after it */
+static void remove_entry(uint16_t *order, uint16_t order_len, uint16_t nth) {
+    uint16_t j = 0;
+    for (uint16_t i = 0; i < order_len; i++) {
+        if (order[i] != nth) {
+            order[j++] = order[i];
+        }
+    }
+}
+
+/* position of the first entry of the group in the grouped permutation */
+static uint16_t group_start(uint8_t group) {
+    uint16_t start = 0;
+    for (uint8_t g = 0; g < group; g++) {
+        start += entry_index.group_counts[g];
+    }
+    return start;
+}
+
+/* group of the nth entry, from its position in the grouped permutation: the record itself
+ * may already be erased */
+static uint8_t indexed_group(uint16_t nth) {
+    uint16_t position = 0;
+    while (position < entry_index.count && entry_index.grouped[position] != nth) {
+        position++;
+    }
+    uint8_t group = 0;
+    uint16_t end = entry_index.group_counts[0];
+    while (end <= position && group + 1 < METADATA_GROUPS) {
+        end += entry_index.group_counts[++group];
+    }
+    return group;
+}
+
+/* entry number of the entry at offset, or count when it is not indexed */
+static uint16_t find_entry(uint32_t offset) {
+    // offsets are ascending: find the entry number by bisection
+    uint16_t low = 0;
+    uint16_t high = entry_index.count;
+    while (low < high) {
+        uint16_t middle = (low + high) / 2;
+        if (entry_index.offsets[middle] < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < entry_index.count && entry_index.offsets[low] != offset) {
+        return entry_index.count;
+    }
+    return low;
+}
+
+static void append_entry(uint32_t offset) {
+    if (entry_index.count >= MAX_INDEXED_ENTRIES) {
+        entry_index.available = false;
+        return;
+    }
+    uint16_t nth = entry_index.count;
+    char nickname[MAX_METANAME + 1];
+    uint8_t len = get_metadata_nickname(offset, nickname);
+    entry_index.offsets[nth] = offset;
+    entry_index.fingerprints[nth] = fingerprint(METADATA_SETS(offset), nickname, len);
+    insert_entry(entry_index.sorted, entry_index.count, compare_nicknames, nth);
+    insert_entry(entry_index.recent, entry_index.count, compare_last_uses, nth);
+    insert_entry(entry_index.grouped, entry_index.count, compare_groups, nth);
+    entry_index.group_counts[METADATA_GROUP(offset)]++;
+    entry_index.count++;
+}
+
+void entry_index_build(void) {
+    entry_index.generation++;
+    entry_index.count = 0;
+    entry_index.available = true;
+    os_memset(entry_index.group_counts, 0, sizeof(entry_index.group_counts));
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END && entry_index.available;
+         offset = metadata_next_entry(offset)) {
+        append_entry(offset);
+    }
+}
+
+void entry_index_on_write(uint32_t offset) {
+    entry_index.generation++;
+    if (entry_index.available) {
+        append_entry(offset);
+    }
+}
+
+void entry_index_on_erase(uint32_t offset) {
+    entry_index.generation++;
+    if (!entry_index.available) {
+        return;
+    }
+    uint16_t nth = find_entry(offset);
+    if (nth == entry_index.count) {
+        return;
+    }
+    entry_index.group_counts[indexed_group(nth)]--;
+    remove_entry(entry_index.sorted, entry_index.count, nth);
+    remove_entry(entry_index.recent, entry_index.count, nth);
+    remove_entry(entry_index.grouped, entry_index.count, nth);
+    entry_index.count--;
+    os_memmove(&entry_index.offsets[nth],
+               &entry_index.offsets[nth + 1],
+               (entry_index.count - nth) * sizeof(entry_index.offsets[0]));
+    os_memmove(&entry_index.fingerprints[nth],
+               &entry_index.fingerprints[nth + 1],
+               (entry_index.count - nth) * sizeof(entry_index.fingerprints[0]));
+    // renumber the entries which followed it
+    for (uint16_t i = 0; i < entry_index.count; i++) {
+        if (entry_index.sorted[i] > nth) {
+            entry_index.sorted[i]--;
+        }
+        if (entry_index.recent[i] > nth) {
+            entry_index.recent[i]--;
+        }
+        if (entry_index.grouped[i] > nth) {
+            entry_index.grouped[i]--;
+        }
+    }
+}
+
+void entry_index_on_use(uint32_t offset) {
+    entry_index.generation++;
+    if (!entry_index.available) {
+        return;
+    }
+    uint16_t nth = find_entry(offset);
+    if (nth == entry_index.count) {
+        return;
+    }
+    remove_entry(entry_index.recent, entry_index.count, nth);
+    insert_entry(entry_index.recent, entry_index.count - 1, compare_last_uses, nth);
+}
+
+void entry_index_on_group_change(uint32_t offset) {
+    entry_index.generation++;
+    if (!entry_index.available) {
+        return;
+    }
+    uint16_t nth = find_entry(offset);
+    if (nth == entry_index.count) {
+        return;
+    }
+    entry_index.group_counts[indexed_group(nth)]--;
+    remove_entry(entry_index.grouped, entry_index.count, nth);
+    insert_entry(entry_index.grouped, entry_index.count - 1, compare_groups, nth);
+    entry_index.group_counts[METADATA_GROUP(offset)]++;
+}
+
+void entry_index_on_compact(void) {
+    // compaction keeps the live entries in the same order, only their offsets change
+    entry_index.generation++;
+    if (!entry_index.available) {
+        return;
+    }
+    uint16_t nth = 0;
+    for (uint32_t offset = metadata_first_entry();
+         offset != METADATA_END && nth < entry_index.count;
+         offset = metadata_next_entry(offset)) {
+        entry_index.offsets[nth++] = offset;
+    }
+}
+
+uint16_t entry_index_generation(void) {
+    return entry_index.generation;
+}
+
+bool entry_index_available(void) {
+    return entry_index.available;
+}
+
+uint16_t entry_index_count(void) {
+    return entry_index.count;
+}
+
+uint32_t entry_index_offset(uint16_t nth) {
+    if (!entry_index.available || nth >= entry_index.count) {
+        return METADATA_END;
+    }
+    return entry_index.offsets[nth];
+}
+
+uint32_t entry_index_sorted_offset(uint16_t rank) {
+    if (!entry_index.available || rank >= entry_index.count) {
+        return METADATA_END;
+    }
+    return entry_index.offsets[entry_index.sorted[rank]];
+}
+
+uint32_t entry_index_recent_offset(uint16_t rank) {
+    if (!entry_index.available || rank >= entry_index.count) {
+        return METADATA_END;
+    }
+    return entry_index.offsets[entry_index.recent[rank]];
+}
+
+uint16_t entry_index_group_count(uint8_t group) {
+    if (!entry_index.available || group >= METADATA_GROUPS) {
+        return 0;
+    }
+    return entry_index.group_counts[group];
+}
+
+uint32_t entry_index_group_offset(uint8_t group, uint16_t rank) {
+    if (rank >= entry_index_group_count(group)) {
+        return METADATA_END;
+    }
+    return entry_index.offsets[entry_index.grouped[group_start(group) + rank]];
+}
+
+static char initial_at(uint16_t rank) {
+    uint32_t offset = entry_index.offsets[entry_index.sorted[rank]];
+    char nickname[MAX_METANAME + 1];
+    return get_metadata_nickname(offset, nickname) ? to_lower(nickname[0]) : 0;
+}
+
+uint16_t entry_index_next_initial(uint16_t rank) {
+    if (rank >= entry_index.count) {
+        return entry_index.count;
+    }
+    return entry_index_lower_bound(initial_at(rank) + 1);
+}
+
+uint16_t entry_index_previous_initial(uint16_t rank) {
+    if (rank == 0 || entry_index.count == 0) {
+        return 0;
+    }
+    if (rank > entry_index.count) {
+        rank = entry_index.count;
+    }
+    // from the first entry of a group, go to the first entry of the previous one
+    return entry_index_lower_bound(initial_at(rank - 1));
+}
+
+uint16_t entry_index_lower_bound(char c) {
+    uint16_t low = 0;
+    uint16_t high = entry_index.count;
+    c = to_lower(c);
+    while (low < high) {
+        uint16_t middle = (low + high) / 2;
+        if (initial_at(middle) < c) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+uint32_t entry_index_find(uint8_t sets, const char *nickname, uint8_t len) {
+    if (!entry_index.available) {
+        for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+             offset = metadata_next_entry(offset)) {
+            if (same_entry(offset, sets, nickname, len)) {
+                return offset;
+            }
+        }
+        return METADATA_END;
+    }
+    // only the entries with the same fingerprint are read
+    uint16_t expected = fingerprint(sets, nickname, len);
+    for (uint16_t nth = 0; nth < entry_index.count; nth++) {
+        if (entry_index.fingerprints[nth] == expected &&
+            same_entry(entry_index.offsets[nth], sets, nickname, len)) {
+            return entry_index.offsets[nth];
+        }
+    }
+    return METADATA_END;
+}
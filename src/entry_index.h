@@ -0,0 +1,54 @@
+#ifndef __ENTRY_INDEX_H__
+#define __ENTRY_INDEX_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+#include "metadata.h"
+
+/* entries the RAM index can hold, set for each device; stores with more entries are only
+ * browsed in log order */
+#ifndef MAX_INDEXED_ENTRIES
+#define MAX_INDEXED_ENTRIES 512
+#endif
+
+/*
+ * RAM index of the live entries: their offsets in log order with a 16-bit fingerprint of
+ * their charsets and nickname, a permutation of them ordered
+ * by nickname (case insensitive), one ordered by last use, favourites first, and one ordered
+ * by group then nickname, along with the number of entries of each group. It is built once
+ * at startup, then kept up to date by the metadata functions on each insert, erase, group
+ * change and compaction, and by the usage tracking on each use, instead of being sorted
+ * again.
+ */
+void entry_index_build(void);
+void entry_index_on_write(uint32_t offset);
+void entry_index_on_erase(uint32_t offset);
+void entry_index_on_compact(void);
+void entry_index_on_use(uint32_t offset);
+void entry_index_on_group_change(uint32_t offset);
+
+/* changes whenever entries are added, erased, moved or used */
+uint16_t entry_index_generation(void);
+bool entry_index_available(void);
+uint16_t entry_index_count(void);
+/* offset of the nth entry in log order */
+uint32_t entry_index_offset(uint16_t nth);
+/* offset of the entry at the given rank in alphabetical order */
+uint32_t entry_index_sorted_offset(uint16_t rank);
+/* offset of the entry at the given rank, favourites and most recently used first */
+uint32_t entry_index_recent_offset(uint16_t rank);
+uint16_t entry_index_group_count(uint8_t group);
+/* offset of the entry at the given rank among the entries of the group, alphabetically */
+uint32_t entry_index_group_offset(uint8_t group, uint16_t rank);
+/* offset of the first entry in log order with these charsets and nickname, METADATA_END if
+ * none; without the index, the log is read */
+uint32_t entry_index_find(uint8_t sets, const char *nickname, uint8_t len);
+/* rank of the first entry whose nickname starts with c or a following letter */
+uint16_t entry_index_lower_bound(char c);
+/* rank of the first entry of the next initial letter group, count past the last one */
+uint16_t entry_index_next_initial(uint16_t rank);
+/* rank of the first entry of the group of the entry before rank */
+uint16_t entry_index_previous_initial(uint16_t rank);
+
+#endif
@@ -0,0 +1,104 @@
+#include "entry_search.h"
+
+#include "os.h"
+#include "string.h"
+
+#include "globals.h"
+#include "metadata.h"
+#include "entry_index.h"
+
+typedef struct entry_search_s {
+    char query[MAX_METANAME + 1];
+    uint16_t match_count;
+    uint16_t generation;  // of the entry index, when the matches were computed
+    uint8_t matches[(MAX_METADATA_ENTRIES + 7) / 8];  // bit n set when entry n matches
+} entry_search_t;
+
+static entry_search_t entry_search;
+
+#define IS_MATCH(n)    (entry_search.matches[(n) / 8] & (1 << ((n) % 8)))
+#define CLEAR_MATCH(n) (entry_search.matches[(n) / 8] &= ~(1 << ((n) % 8)))
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static bool nickname_contains(uint32_t offset, const char *query, size_t query_len) {
+    char nickname[MAX_METANAME + 1];
+    size_t nickname_len = get_metadata_nickname(offset, nickname);
+    for (size_t start = 0; start + query_len <= nickname_len; start++) {
+        size_t i = 0;
+        while (i < query_len && to_lower(nickname[start + i]) == to_lower(query[i])) {
+            i++;
+        }
+        if (i == query_len) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void entry_search_reset(void) {
+    os_memset(&entry_search, 0, sizeof(entry_search));
+    // the empty query matches every entry
+    os_memset(entry_search.matches, 0xFF, sizeof(entry_search.matches));
+    entry_search.match_count = N_storage.metadata_count;
+    entry_search.generation = entry_index_generation();
+}
+
+void entry_search_update(const char *query) {
+    size_t query_len = strlen(query);
+    size_t previous_len = strlen(entry_search.query);
+    // a longer query can only match a subset of the previous matches, otherwise start over
+    if (query_len < previous_len || strncmp(query, entry_search.query, previous_len) != 0) {
+        entry_search_reset();
+    }
+    strncpy(entry_search.query, query, sizeof(entry_search.query) - 1);
+
+    // single pass over the log, only testing the entries which still match
+    uint16_t count = 0;
+    uint16_t n = 0;
+    for (uint32_t offset = metadata_first_entry();
+         offset != METADATA_END && n < MAX_METADATA_ENTRIES;
+         offset = metadata_next_entry(offset), n++) {
+        if (IS_MATCH(n)) {
+            if (nickname_contains(offset, query, query_len)) {
+                count++;
+            } else {
+                CLEAR_MATCH(n);
+            }
+        }
+    }
+    entry_search.match_count = count;
+    entry_search.generation = entry_index_generation();
+}
+
+/* the matches are numbered in log order: once entries were added, erased or moved, for
+ * instance by the upgrade of a legacy record when its usage data is written, they are
+ * computed again */
+static void check_generation(void) {
+    if (entry_search.generation != entry_index_generation()) {
+        char query[MAX_METANAME + 1];
+        strncpy(query, entry_search.query, sizeof(query));
+        entry_search_reset();
+        entry_search_update(query);
+    }
+}
+
+uint16_t entry_search_count(void) {
+    check_generation();
+    return entry_search.match_count;
+}
+
+int32_t entry_search_nth(uint16_t nth) {
+    check_generation();
+    for (uint16_t n = 0; n < N_storage.metadata_count && n < MAX_METADATA_ENTRIES; n++) {
+        if (IS_MATCH(n)) {
+            if (nth == 0) {
+                return n;
+            }
+            nth--;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,16 @@
+#ifndef __ENTRY_SEARCH_H__
+#define __ENTRY_SEARCH_H__
+
+#include "stdint.h"
+
+/*
+ * Set of the entries whose nickname contains a query (case insensitive), narrowed in place
+ * when the query only grows so that typing a character only re-checks the current matches.
+ */
+void entry_search_reset(void);
+void entry_search_update(const char *query);
+uint16_t entry_search_count(void);
+/* index, in the entries list, of the nth match or -1 */
+int32_t entry_search_nth(uint16_t nth);
+
+#endif
@@ -0,0 +1,164 @@
+#include "entry_usage.h"
+
+#include "os.h"
+
+#include "globals.h"
+#include "entry_index.h"
+#include "store_stats.h"
+
+#define USAGE_CLOCK_MAX 0xFFFF
+
+typedef struct pending_usage_s {
+    uint32_t offset;
+    metadata_ext_t ext;
+} pending_usage_t;
+
+static pending_usage_t pending_usage[USAGE_PENDING_SIZE];
+static uint8_t pending_count;
+static uint16_t usage_clock;  // last_used value of the most recently used entry
+static uint16_t idle_ticks;
+
+static uint16_t read_last_used(const metadata_ext_t *ext) {
+    return (ext->last_used[0] << 8) | ext->last_used[1];
+}
+
+static void write_last_used(metadata_ext_t *ext, uint16_t last_used) {
+    ext->last_used[0] = last_used >> 8;
+    ext->last_used[1] = last_used & 0xFF;
+}
+
+static void read_stored_ext(uint32_t offset, metadata_ext_t *ext) {
+    if (METADATA_HAS_EXT(offset)) {
+        os_memcpy(ext, (const void *) METADATA_EXT(offset), sizeof(*ext));
+    } else {
+        os_memset(ext, 0, sizeof(*ext));
+    }
+}
+
+static int find_pending(uint32_t offset) {
+    for (uint8_t i = 0; i < pending_count; i++) {
+        if (pending_usage[i].offset == offset) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static metadata_ext_t *get_pending_ext(uint32_t offset) {
+    int i = find_pending(offset);
+    if (i < 0) {
+        if (pending_count == USAGE_PENDING_SIZE) {
+            entry_usage_flush();
+        }
+        i = pending_count++;
+        pending_usage[i].offset = offset;
+        read_stored_ext(offset, &pending_usage[i].ext);
+    }
+    idle_ticks = 0;
+    return &pending_usage[i].ext;
+}
+
+/* rewrites a legacy record with an extension, at the end of the log, packing its nickname */
+static void upgrade_record(uint32_t offset, const metadata_ext_t *ext) {
+    uint8_t data[1 + MAX_METANAME + 1];
+    data[0] = METADATA_SETS(offset);
+    uint8_t data_len = 1 + get_metadata_nickname(offset, (char *) data + 1);
+    // the copy is written first: an interruption leaves a duplicate, never a lost entry
+    if (append_metadata(data, data_len, ext, 0) == OK) {
+        erase_metadata(offset);
+    }
+}
+
+/* halves every last_used value, which keeps the entries in the same order */
+static void rescale_clock(void) {
+    entry_usage_flush();
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset)) {
+        if (METADATA_HAS_EXT(offset)) {
+            metadata_ext_t ext;
+            read_stored_ext(offset, &ext);
+            write_last_used(&ext, read_last_used(&ext) / 2);
+            store_write((void *) METADATA_EXT(offset), &ext, sizeof(ext));
+        }
+    }
+    usage_clock /= 2;
+}
+
+void entry_usage_init(void) {
+    pending_count = 0;
+    usage_clock = 0;
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset)) {
+        if (METADATA_HAS_EXT(offset)) {
+            uint16_t last_used = read_last_used((const metadata_ext_t *) METADATA_EXT(offset));
+            if (last_used > usage_clock) {
+                usage_clock = last_used;
+            }
+        }
+    }
+}
+
+void entry_usage_record(uint32_t offset) {
+    if (usage_clock == USAGE_CLOCK_MAX) {
+        rescale_clock();
+    }
+    metadata_ext_t *ext = get_pending_ext(offset);
+    write_last_used(ext, ++usage_clock);
+    if (ext->uses < 0xFF) {
+        ext->uses++;
+    }
+    entry_index_on_use(offset);
+}
+
+void entry_usage_toggle_favourite(uint32_t offset) {
+    metadata_ext_t *ext = get_pending_ext(offset);
+    ext->flags ^= EXT_FLAG_FAVOURITE;
+    entry_index_on_use(offset);
+}
+
+void entry_usage_get(uint32_t offset, metadata_ext_t *ext) {
+    int i = find_pending(offset);
+    if (i < 0) {
+        read_stored_ext(offset, ext);
+    } else {
+        os_memcpy(ext, &pending_usage[i].ext, sizeof(*ext));
+    }
+}
+
+uint16_t entry_usage_last_used(uint32_t offset) {
+    metadata_ext_t ext;
+    entry_usage_get(offset, &ext);
+    return read_last_used(&ext);
+}
+
+bool entry_usage_is_favourite(uint32_t offset) {
+    metadata_ext_t ext;
+    entry_usage_get(offset, &ext);
+    return (ext.flags & EXT_FLAG_FAVOURITE) != 0;
+}
+
+void entry_usage_flush(void) {
+    // upgrading a legacy record appends and erases, neither moves the other records
+    for (uint8_t i = 0; i < pending_count; i++) {
+        uint32_t offset = pending_usage[i].offset;
+        const metadata_ext_t *ext = &pending_usage[i].ext;
+        if (METADATA_HAS_EXT(offset)) {
+            if (os_memcmp((const void *) METADATA_EXT(offset), ext, sizeof(*ext)) != 0) {
+                store_write((void *) METADATA_EXT(offset), (void *) ext, sizeof(*ext));
+            }
+        } else if (METADATA_FORMAT(offset) == META_NONE) {
+            upgrade_record(offset, ext);
+        }
+    }
+    pending_count = 0;
+}
+
+void entry_usage_discard(void) {
+    pending_count = 0;
+}
+
+void entry_usage_on_ticker(void) {
+    if (pending_count != 0 && ++idle_ticks >= USAGE_FLUSH_DELAY_TICKS) {
+        entry_usage_flush();
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef __ENTRY_USAGE_H__
+#define __ENTRY_USAGE_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+#include "metadata.h"
+
+/* entries whose usage data can wait in RAM before being written */
+#define USAGE_PENDING_SIZE 8
+/* ticker events (100ms) without any use after which pending usage data is written */
+#define USAGE_FLUSH_DELAY_TICKS 100
+
+/*
+ * Per entry usage counters and favourite flag, stored in the extension of the record.
+ * Updates are kept in RAM and written together once the device has been left alone for a
+ * while, before any record is moved, and when leaving the app: an entry used several times
+ * in a row costs a single write. Legacy records get their extension on the first flush.
+ */
+void entry_usage_init(void);
+void entry_usage_record(uint32_t offset);
+void entry_usage_toggle_favourite(uint32_t offset);
+/* usage data of the entry, including the updates not written yet */
+void entry_usage_get(uint32_t offset, metadata_ext_t *ext);
+uint16_t entry_usage_last_used(uint32_t offset);
+bool entry_usage_is_favourite(uint32_t offset);
+void entry_usage_flush(void);
+void entry_usage_discard(void);
+void entry_usage_on_ticker(void);
+
+#endif
@@ -16,6 +16,9 @@ extern volatile unsigned int G_led_status;
 #define OFFSET_LC    4
 #define OFFSET_CDATA 5
 
+/* wipes the cached seeds and writes the data kept in RAM, before leaving the app */
+void app_save_before_exit(void);
+
 #define CLA       0xE0
 #define N_storage (*(volatile internalStorage_t*) PIC(&N_storage_real))
 
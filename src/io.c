@@ -21,6 +21,13 @@
 #include "io.h"
 
 #include "globals.h"
+#include "password_prefetch.h"
+#include "derivation_cache.h"
+#include "entry_usage.h"
+#include "virtual_list.h"
+#include "metadata.h"
+#include "password_ui_flows.h"
+#include "store_stats.h"
 
 void io_seproxyhal_display(const bagl_element_t *element) {
     io_seproxyhal_display_default((bagl_element_t *) element);
@@ -32,6 +39,7 @@ uint8_t io_event(uint8_t channel) {
             UX_FINGER_EVENT(G_io_seproxyhal_spi_buffer);
             break;
         case SEPROXYHAL_TAG_BUTTON_PUSH_EVENT:
+            compaction_postpone();
             UX_BUTTON_PUSH_EVENT(G_io_seproxyhal_spi_buffer);
             break;
         case SEPROXYHAL_TAG_STATUS_EVENT:
@@ -49,6 +57,16 @@ uint8_t io_event(uint8_t channel) {
             break;
         case SEPROXYHAL_TAG_TICKER_EVENT:
             UX_TICKER_EVENT(G_io_seproxyhal_spi_buffer, {});
+            password_prefetch_on_ticker();
+            derivation_cache_on_ticker();
+            entry_usage_on_ticker();
+            store_stats_on_ticker();
+            virtual_list_on_ticker();
+            ui_on_ticker();
+            // the marked entries are kept by offset, records only move once they are deleted
+            if (!ui_has_marked_entries()) {
+                compaction_on_ticker();
+            }
             break;
     }
     if (!io_seproxyhal_spi_is_status_sent()) {
@@ -0,0 +1,98 @@
+#include "keyboard_order.h"
+
+#include "os.h"
+#include "string.h"
+
+#include "globals.h"
+#include "metadata.h"
+
+/* items following the characters in a wheel once a character has been entered: backspace,
+ * validate and back to classes */
+#define WHEEL_CONTROLS_COUNT 3
+
+/* most frequent first, in typical nicknames (service names and domains) */
+static const char DEFAULT_LETTERS_RANKING[] = "eoamictrnslpdgubkhfywvxzjq";
+static const char DEFAULT_QUICK_RANKING[] = ".-@1203456789";
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/* position of c in chars, -1 if absent */
+static int find_char(const char *chars, size_t count, char c) {
+    const char *found = memchr(chars, c, count);
+    return found != NULL ? found - chars : -1;
+}
+
+/* sorts ranking by decreasing count, keeping the default ranking between equal counts */
+static void rank(char *ranking, size_t count, const uint16_t *counts, const char *chars) {
+    for (size_t i = 1; i < count; i++) {
+        char c = ranking[i];
+        uint16_t c_count = counts[find_char(chars, count, c)];
+        size_t j = i;
+        while (j > 0 && counts[find_char(chars, count, ranking[j - 1])] < c_count) {
+            ranking[j] = ranking[j - 1];
+            j--;
+        }
+        ranking[j] = c;
+    }
+}
+
+/* places the characters from the most frequent, on the free position closest to the first
+ * item going forward or backward through the controls */
+static void arrange(const char *ranking, size_t count, char *wheel) {
+    size_t size = count + WHEEL_CONTROLS_COUNT;
+    size_t forward = 0;
+    size_t backward = count - 1;
+    for (size_t i = 0; i < count; i++) {
+        if (forward <= size - backward) {
+            wheel[forward++] = ranking[i];
+        } else {
+            wheel[backward--] = ranking[i];
+        }
+    }
+    wheel[count] = '\0';
+}
+
+void keyboard_order_compute(keyboard_order_t *order) {
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+    uint16_t letters_counts[KEYBOARD_ORDER_LETTERS_COUNT];
+    uint16_t quick_counts[KEYBOARD_ORDER_QUICK_COUNT];
+    char letters_ranking[KEYBOARD_ORDER_LETTERS_COUNT];
+    char quick_ranking[KEYBOARD_ORDER_QUICK_COUNT];
+    uint32_t samples = 0;
+
+    os_memset(letters_counts, 0, sizeof(letters_counts));
+    os_memset(quick_counts, 0, sizeof(quick_counts));
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset)) {
+        char nickname[MAX_METANAME + 1];
+        size_t nickname_len = get_metadata_nickname(offset, nickname);
+        for (size_t i = 0; i < nickname_len; i++) {
+            char c = to_lower(nickname[i]);
+            int letter = find_char(letters, KEYBOARD_ORDER_LETTERS_COUNT, c);
+            int quick = find_char(KEYBOARD_ORDER_QUICK_CHARS, KEYBOARD_ORDER_QUICK_COUNT, c);
+            if (letter >= 0 && letters_counts[letter] < UINT16_MAX) {
+                letters_counts[letter]++;
+                samples++;
+            } else if (quick >= 0 && quick_counts[quick] < UINT16_MAX) {
+                quick_counts[quick]++;
+                samples++;
+            }
+        }
+    }
+
+    memcpy(letters_ranking, DEFAULT_LETTERS_RANKING, sizeof(letters_ranking));
+    memcpy(quick_ranking, DEFAULT_QUICK_RANKING, sizeof(quick_ranking));
+    if (samples >= KEYBOARD_ORDER_MIN_SAMPLES) {
+        rank(letters_ranking, KEYBOARD_ORDER_LETTERS_COUNT, letters_counts, letters);
+        rank(quick_ranking, KEYBOARD_ORDER_QUICK_COUNT, quick_counts, KEYBOARD_ORDER_QUICK_CHARS);
+    }
+
+    arrange(letters_ranking, KEYBOARD_ORDER_LETTERS_COUNT, order->lowercase);
+    arrange(quick_ranking, KEYBOARD_ORDER_QUICK_COUNT, order->quick);
+    for (size_t i = 0; i <= KEYBOARD_ORDER_LETTERS_COUNT; i++) {
+        char c = order->lowercase[i];
+        order->uppercase[i] = (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef __KEYBOARD_ORDER_H__
+#define __KEYBOARD_ORDER_H__
+
+#include "stdint.h"
+
+#define KEYBOARD_ORDER_LETTERS_COUNT 26
+/* the characters of KEYBOARD_CLASS_QUICK */
+#define KEYBOARD_ORDER_QUICK_CHARS ".-@0123456789"
+#define KEYBOARD_ORDER_QUICK_COUNT (sizeof(KEYBOARD_ORDER_QUICK_CHARS) - 1)
+/* characters of the existing nicknames needed before preferring their statistics */
+#define KEYBOARD_ORDER_MIN_SAMPLES 64
+
+typedef struct keyboard_order_s {
+    char lowercase[KEYBOARD_ORDER_LETTERS_COUNT + 1];
+    char uppercase[KEYBOARD_ORDER_LETTERS_COUNT + 1];
+    char quick[KEYBOARD_ORDER_QUICK_COUNT + 1];
+} keyboard_order_t;
+
+/*
+ * Keyboard wheels with the most frequent characters closest to their first item, on either
+ * side as the wheels wrap around, so that typing a nickname takes fewer button presses. The
+ * frequencies are those of the existing nicknames once there are enough of them, typical
+ * nickname frequencies otherwise.
+ */
+void keyboard_order_compute(keyboard_order_t *order);
+
+#endif
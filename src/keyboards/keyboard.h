@@ -18,6 +18,7 @@
 #ifndef BOLOS_UX_H
 #define BOLOS_UX_H
 
+#include "stdbool.h"
 #include "os_io_seproxyhal.h"
 #include "ux.h"
 
@@ -32,7 +33,19 @@
 #define KEYBOARD_RENDER_WORD \
     3  // callback is called with a -1 when requesting complete word, or the char
        // index else, returnin 0 implies no char is to be displayed
+
+// character classes of the text keyboard
+#define KEYBOARD_CLASS_LOWERCASE 0
+#define KEYBOARD_CLASS_UPPERCASE 1
+#define KEYBOARD_CLASS_SYMBOLS   2
+#define KEYBOARD_CLASS_QUICK     3  // '.', '-', '@' and digits
+#define KEYBOARD_CLASSES_COUNT   4
+
 typedef const bagl_element_t* (*keyboard_callback_t)(unsigned int event, unsigned int value);
+// fills completion with the text to append to the entered text, returns false if none
+typedef bool (*keyboard_completion_t)(const char* text,
+                                      char* completion,
+                                      unsigned int completion_size);
 
 // bolos ux context (not mandatory if redesigning a bolos ux)
 typedef struct keyboard_ctx {
@@ -77,5 +90,12 @@ void screen_common_keyboard_init(unsigned int stack_slot,
                                  unsigned int nb_elements,
                                  keyboard_callback_t callback);
 void screen_text_keyboard_init(char* buffer, unsigned int maxsize, appmain_t validation_callback);
+// called after each character entered or erased, until the next screen_text_keyboard_init
+void screen_text_keyboard_set_change_callback(appmain_t change_callback);
+// offers the completion as the last item of the character wheels, until the next init
+void screen_text_keyboard_set_completion_callback(keyboard_completion_t completion_callback);
+// replaces the characters of a class wheel, in their new order, until the next init; characters
+// is not copied and must outlive the keyboard
+void screen_text_keyboard_set_class_order(unsigned int char_class, const char* characters);
 
 #endif  // BOLOS_UX_H
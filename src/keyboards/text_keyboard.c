@@ -2,47 +2,134 @@
 #include "ux.h"
 #include "string.h"
 #include "stdint.h"
+#include "stdbool.h"
 #include "keyboard.h"
 
+// default order of the characters of each class, see screen_text_keyboard_set_class_order()
 const char* const screen_keyboard_classes_elements[] = {
+    "abcdefghijklmnopqrstuvwxyz",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+    "0123456789 '\"`&/?!:;.,~*$=+-[](){}<>\\_#@|%",
+    // the symbols and digits most found in nicknames, without going through the whole list
+    ".-@0123456789",
+};
+
+// items following the characters
+const char* const screen_keyboard_classes_controls[] = {
     // when first letter is already entered
-    "abcdefghijklmnopqrstuvwxyz\b\n\r",
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ\b\n\r",
-    "0123456789 '\"`&/?!:;.,~*$=+-[](){}<>\\_#@|%\b\n\r",
+    "\b\n\r",
     // when first letter is not entered yet
-    "abcdefghijklmnopqrstuvwxyz\r",
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ\r",
-    "0123456789 '\"`&/?!:;.,~*$=+-[](){}<>\\_#@|%\r",
+    "\r",
 };
 
-#define GET_CHAR(char_class, char_idx) \
-    ((char*) PIC(screen_keyboard_classes_elements[char_class]))[char_idx]
+// character classes order set by the application, NULL for the default one
+const char* screen_keyboard_classes_order[KEYBOARD_CLASSES_COUNT];
+
+#define GET_CHAR(char_class, char_idx) screen_keyboard_get_char(char_class, char_idx)
+// the completion item follows the last character of the class
+#define IS_COMPLETION_ITEM(char_class, char_idx) (GET_CHAR(char_class, char_idx) == '\0')
+
+// the classes wheel lists the character classes, then backspace and validate once a character
+// has been entered
+#define KEYBOARD_CLASS_BACKSPACE KEYBOARD_CLASSES_COUNT
+#define KEYBOARD_CLASS_VALIDATE  (KEYBOARD_CLASSES_COUNT + 1)
+#define CLASSES_ITEMS_COUNT() \
+    (strlen(PP_BUFFER) ? KEYBOARD_CLASSES_COUNT + 2 : KEYBOARD_CLASSES_COUNT)
 
-// these icons will be centered
+#define KEYBOARD_ICON_BACKSPACE 4
+#define KEYBOARD_ICON_VALIDATE  5
+#define KEYBOARD_ICON_CLASSES   6
+#define KEYBOARD_ICON_COMPLETE  7
+#define KEYBOARD_ICONS_COUNT    8
+
+// these icons will be centered, the first ones are those of the classes wheel items
 const bagl_icon_details_t* const screen_keyboard_classes_icons[] = {
     &C_icon_lowercase,
     &C_icon_uppercase,
     &C_icon_digits,
+    &C_icon_quick,
     &C_icon_backspace,
     &C_icon_validate,
     &C_icon_classes,
+    &C_icon_complete,
 #if defined(TARGET_NANOX) || defined(TARGET_NANOS2)
     &C_icon_lowercase_invert,
     &C_icon_uppercase_invert,
     &C_icon_digits_invert,
+    &C_icon_quick_invert,
     &C_icon_backspace_invert,
     &C_icon_validate_invert,
     &C_icon_classes_invert,
+    &C_icon_complete_invert,
 #endif
 };
 
 const bagl_element_t* screen_keyboard_class_callback(unsigned int event, unsigned int value);
 appmain_t screen_keyboard_validation;
+appmain_t screen_keyboard_change;
+keyboard_completion_t screen_keyboard_completer;
 char* screen_keyboard_buffer;
 unsigned int screen_keyboard_buffer_maxsize;
+// text appended by the completion item, empty when there is none
+char screen_keyboard_completion[sizeof(G_keyboard_ctx.words_buffer)];
+// entered text followed by the completion, displayed while the completion item is selected
+char screen_keyboard_completed[sizeof(G_keyboard_ctx.words_buffer)];
 
 #define PP_BUFFER screen_keyboard_buffer
 
+const char* screen_keyboard_class_chars(unsigned int char_class) {
+    char_class %= KEYBOARD_CLASSES_COUNT;
+    if (screen_keyboard_classes_order[char_class] != NULL) {
+        return screen_keyboard_classes_order[char_class];
+    }
+    return (const char*) PIC(screen_keyboard_classes_elements[char_class]);
+}
+
+const char* screen_keyboard_class_controls(unsigned int char_class) {
+    return (const char*) PIC(
+        screen_keyboard_classes_controls[char_class < KEYBOARD_CLASSES_COUNT ? 0 : 1]);
+}
+
+/* character at char_idx in the class wheel, '\0' for the completion item */
+char screen_keyboard_get_char(unsigned int char_class, unsigned int char_idx) {
+    const char* chars = screen_keyboard_class_chars(char_class);
+    unsigned int len = strlen(chars);
+    if (char_idx < len) {
+        return chars[char_idx];
+    }
+    return screen_keyboard_class_controls(char_class)[char_idx - len];
+}
+
+void screen_keyboard_update_completion(void) {
+    unsigned int room = screen_keyboard_buffer_maxsize - strlen(PP_BUFFER);
+    screen_keyboard_completion[0] = '\0';
+    if (screen_keyboard_completer == NULL || strlen(PP_BUFFER) == 0 || room == 0) {
+        return;
+    }
+    if (room >= sizeof(screen_keyboard_completion)) {
+        room = sizeof(screen_keyboard_completion) - 1;
+    }
+    if (!screen_keyboard_completer(PP_BUFFER, screen_keyboard_completion, room + 1)) {
+        screen_keyboard_completion[0] = '\0';
+    }
+    strcpy(screen_keyboard_completed, PP_BUFFER);
+    strcat(screen_keyboard_completed, screen_keyboard_completion);
+}
+
+void screen_keyboard_buffer_changed(void) {
+    screen_keyboard_update_completion();
+    if (screen_keyboard_change != NULL) {
+        screen_keyboard_change();
+    }
+}
+
+/* characters and controls of the current class, plus the completion item when there is one */
+unsigned int screen_keyboard_items_count(void) {
+    return strlen(screen_keyboard_class_chars(G_keyboard_ctx.onboarding_step)) +
+           strlen(screen_keyboard_class_controls(G_keyboard_ctx.onboarding_step)) +
+           (screen_keyboard_completion[0] != '\0' ? 1 : 0);
+}
+
 void screen_keyboard_render_icon(unsigned int value) {
     const bagl_icon_details_t* icon;
 #if defined(TARGET_NANOS)
@@ -50,7 +137,8 @@ void screen_keyboard_render_icon(unsigned int value) {
     G_ux.tmp_element.component.y = 5;
 #elif defined(TARGET_NANOX) || defined(TARGET_NANOS2)
     uint8_t inverted = G_ux.tmp_element.component.userid == 0x02;
-    icon = (bagl_icon_details_t*) PIC(screen_keyboard_classes_icons[value + (inverted ? 6 : 0)]);
+    icon = (bagl_icon_details_t*) PIC(
+        screen_keyboard_classes_icons[value + (inverted ? KEYBOARD_ICONS_COUNT : 0)]);
     G_ux.tmp_element.component.y -= 7;
 #endif
     G_ux.tmp_element.component.x += G_ux.tmp_element.component.width / 2 - icon->width / 2;
@@ -65,16 +153,22 @@ const bagl_element_t* screen_keyboard_item_callback(unsigned int event, unsigned
     switch (event) {
         case KEYBOARD_ITEM_VALIDATED:
             // depending on the chosen class, interpret the click
-            if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\b') {
+            if (IS_COMPLETION_ITEM(G_keyboard_ctx.onboarding_step, value)) {
+                strcat(PP_BUFFER, screen_keyboard_completion);
+                screen_keyboard_buffer_changed();
+                value = 0;  // back to the first character
+                goto redisplay_current_class;
+            } else if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\b') {
                 if (strlen(PP_BUFFER)) {
                     PP_BUFFER[strlen(PP_BUFFER) - 1] = 0;
+                    screen_keyboard_buffer_changed();
                     goto redisplay_current_class;
                 }
             } else if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\r') {
                 // go back to classes display
                 screen_common_keyboard_init(0,
-                                            G_keyboard_ctx.onboarding_step,
-                                            (strlen(PP_BUFFER) ? 5 : 3),
+                                            G_keyboard_ctx.onboarding_step % KEYBOARD_CLASSES_COUNT,
+                                            CLASSES_ITEMS_COUNT(),
                                             screen_keyboard_class_callback);
                 return NULL;
             } else if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\n') {
@@ -92,18 +186,19 @@ const bagl_element_t* screen_keyboard_item_callback(unsigned int event, unsigned
                 // append the char and display classes again
                 PP_BUFFER[strlen(PP_BUFFER)] = GET_CHAR(G_keyboard_ctx.onboarding_step, value);
                 PP_BUFFER[strlen(PP_BUFFER)] = 0;
+                screen_keyboard_buffer_changed();
 
             redisplay_current_class:
                 // redisplay the correct class depending on the current number of entered digits
                 G_keyboard_ctx.onboarding_step =
-                    (G_keyboard_ctx.onboarding_step % 3) + (strlen(PP_BUFFER) ? 0 : 3);
+                    (G_keyboard_ctx.onboarding_step % KEYBOARD_CLASSES_COUNT) +
+                    (strlen(PP_BUFFER) ? 0 : KEYBOARD_CLASSES_COUNT);
                 screen_common_keyboard_init(
                     0,
-                    (event == KEYBOARD_ITEM_VALIDATED && strlen(PP_BUFFER) == 0)
+                    (event == KEYBOARD_ITEM_VALIDATED && (strlen(PP_BUFFER) == 0 || value == 0))
                         ? 0
                         : COMMON_KEYBOARD_INDEX_UNCHANGED,
-                    strlen((char*) PIC(
-                        screen_keyboard_classes_elements[G_keyboard_ctx.onboarding_step])),
+                    screen_keyboard_items_count(),
                     screen_keyboard_item_callback);
                 return NULL;
             }
@@ -111,14 +206,17 @@ const bagl_element_t* screen_keyboard_item_callback(unsigned int event, unsigned
         case KEYBOARD_RENDER_ITEM:
             G_ux.tmp_element.text = G_ux.string_buffer;
             os_memset(G_ux.string_buffer, 0, 3);
-            if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\b') {
-                value = 3;
+            if (IS_COMPLETION_ITEM(G_keyboard_ctx.onboarding_step, value)) {
+                value = KEYBOARD_ICON_COMPLETE;
+                goto set_bitmap;
+            } else if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\b') {
+                value = KEYBOARD_ICON_BACKSPACE;
                 goto set_bitmap;
             } else if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\r') {
-                value = 5;
+                value = KEYBOARD_ICON_CLASSES;
                 goto set_bitmap;
             } else if (GET_CHAR(G_keyboard_ctx.onboarding_step, value) == '\n') {
-                value = 4;
+                value = KEYBOARD_ICON_VALIDATE;
 
             set_bitmap:
                 screen_keyboard_render_icon(value);
@@ -128,7 +226,14 @@ const bagl_element_t* screen_keyboard_item_callback(unsigned int event, unsigned
             break;
 
         case KEYBOARD_RENDER_WORD: {
-            unsigned int l = strlen(PP_BUFFER);
+            const char* word = PP_BUFFER;
+            // preview the completed text while its item is selected
+            if (G_keyboard_ctx.keyboard_callback == screen_keyboard_item_callback &&
+                IS_COMPLETION_ITEM(G_keyboard_ctx.onboarding_step,
+                                   G_keyboard_ctx.hslider3_current)) {
+                word = screen_keyboard_completed;
+            }
+            unsigned int l = strlen(word);
 
             G_ux.string_buffer[0] = '_';
             G_ux.string_buffer[1] = 0;
@@ -136,7 +241,7 @@ const bagl_element_t* screen_keyboard_item_callback(unsigned int event, unsigned
             if (value < 8) {
                 if (l <= 8) {
                     if (l > value) {
-                        G_ux.string_buffer[0] = PP_BUFFER[value];
+                        G_ux.string_buffer[0] = word[value];
                     } else {
                         G_ux.string_buffer[0] = '_';
                     }
@@ -148,7 +253,7 @@ const bagl_element_t* screen_keyboard_item_callback(unsigned int event, unsigned
                         G_ux.string_buffer[2] = '.';
                         G_ux.string_buffer[3] = 0;
                     } else {
-                        G_ux.string_buffer[0] = (PP_BUFFER + l - 8)[value];
+                        G_ux.string_buffer[0] = (word + l - 8)[value];
                     }
                 }
             }
@@ -165,30 +270,32 @@ const bagl_element_t* screen_keyboard_class_callback(unsigned int event, unsigne
     switch (event) {
         case KEYBOARD_ITEM_VALIDATED:
             switch (value) {
-                case 3:
-                    // backspace
+                case KEYBOARD_CLASS_BACKSPACE:
                     if (strlen(PP_BUFFER)) {
                         PP_BUFFER[strlen(PP_BUFFER) - 1] = 0;
+                        screen_keyboard_buffer_changed();
                         screen_common_keyboard_init(
                             0,
                             strlen(PP_BUFFER) == 0 ? 0 : COMMON_KEYBOARD_INDEX_UNCHANGED,
-                            (strlen(PP_BUFFER) ? 5 : 3),
+                            CLASSES_ITEMS_COUNT(),
                             screen_keyboard_class_callback);
                         return NULL;
                     }
                     break;
-                case 4:
+                case KEYBOARD_CLASS_VALIDATE:
                     screen_keyboard_validation();
                     return NULL;
 
-                case 0:
-                case 1:
-                case 2:
-                    G_keyboard_ctx.onboarding_step = value + (strlen(PP_BUFFER) ? 0 : 3);
+                case KEYBOARD_CLASS_LOWERCASE:
+                case KEYBOARD_CLASS_UPPERCASE:
+                case KEYBOARD_CLASS_SYMBOLS:
+                case KEYBOARD_CLASS_QUICK:
+                    G_keyboard_ctx.onboarding_step =
+                        value + (strlen(PP_BUFFER) ? 0 : KEYBOARD_CLASSES_COUNT);
                     screen_common_keyboard_init(
                         0,
                         0,
-                        strlen(&GET_CHAR(G_keyboard_ctx.onboarding_step, 0)),
+                        screen_keyboard_items_count(),
                         screen_keyboard_item_callback);
                     return NULL;
 
@@ -212,5 +319,22 @@ void screen_text_keyboard_init(char* buffer, unsigned int maxsize, appmain_t val
     screen_keyboard_buffer = buffer;
     screen_keyboard_buffer_maxsize = maxsize;
     screen_keyboard_validation = validation_callback;
-    screen_common_keyboard_init(0, 0, 3, screen_keyboard_class_callback);
-}
\ No newline at end of file
+    screen_keyboard_change = NULL;
+    screen_keyboard_completer = NULL;
+    screen_keyboard_completion[0] = '\0';
+    os_memset(screen_keyboard_classes_order, 0, sizeof(screen_keyboard_classes_order));
+    screen_common_keyboard_init(0, 0, KEYBOARD_CLASSES_COUNT, screen_keyboard_class_callback);
+}
+
+void screen_text_keyboard_set_change_callback(appmain_t change_callback) {
+    screen_keyboard_change = change_callback;
+}
+
+void screen_text_keyboard_set_completion_callback(keyboard_completion_t completion_callback) {
+    screen_keyboard_completer = completion_callback;
+    screen_keyboard_update_completion();
+}
+
+void screen_text_keyboard_set_class_order(unsigned int char_class, const char* characters) {
+    screen_keyboard_classes_order[char_class] = characters;
+}
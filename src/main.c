@@ -37,11 +37,17 @@
 #include "globals.h"
 #include "metadata.h"
 #include "dispatcher.h"
+#include "derivation_cache.h"
+#include "entry_index.h"
+#include "entry_usage.h"
+#include "store_stats.h"
 
 unsigned char G_io_seproxyhal_spi_buffer[IO_SEPROXYHAL_BUFFER_SIZE_B];
 const internalStorage_t N_storage_real;
 app_state_t app_state;
 volatile unsigned int G_led_status;
+/* entries the start up check could not read back */
+static uint16_t dropped_entries;
 
 void app_init() {
     if (N_storage.magic != STORAGE_MAGIC) {
@@ -54,12 +60,35 @@ void app_init() {
         nvm_write((void *) &N_storage.keyboard_layout,
                   (void *) &tmp,
                   sizeof(N_storage.keyboard_layout));
+        nvm_write((void *) &N_storage.cache_recent_passwords,
+                  (void *) &tmp,
+                  sizeof(N_storage.cache_recent_passwords));
+        nvm_write((void *) &N_storage.list_order, (void *) &tmp, sizeof(N_storage.list_order));
         nvm_write((void *) &N_storage.metadata_count,
                   (void *) &tmp,
                   sizeof(N_storage.metadata_count));
-        nvm_write((void *) N_storage.metadatas, (void *) &tmp, 2);
+        nvm_write((void *) &N_storage.metadata_digest,
+                  (void *) &tmp,
+                  sizeof(N_storage.metadata_digest));
+        nvm_write((void *) &N_storage.active_bank, (void *) &tmp, sizeof(N_storage.active_bank));
+        tmp = METADATA_VERSION;
+        nvm_write((void *) &N_storage.metadata_version,
+                  (void *) &tmp,
+                  sizeof(N_storage.metadata_version));
+        tmp = 0;
+        nvm_write((void *) &N_storage.migration.version,
+                  (void *) &tmp,
+                  sizeof(N_storage.migration.version));
+        nvm_write((void *) METADATA_PTR(0), (void *) &tmp, 2);
+        nvm_write((void *) N_storage.journal, NULL, sizeof(N_storage.journal));
+        nvm_write((void *) &N_storage.store_counters, NULL, sizeof(N_storage.store_counters));
     }
     memset(&app_state, 0, sizeof(app_state));
+    recover_metadata();
+    migrate_metadatas();
+    dropped_entries = check_metadatas(false);
+    entry_usage_init();
+    entry_index_build();
 }
 
 void app_main() {
@@ -101,7 +130,14 @@ void app_main() {
     }
 }
 
+void app_save_before_exit(void) {
+    derivation_cache_wipe();
+    entry_usage_flush();
+    store_stats_flush();
+}
+
 void app_exit(void) {
+    app_save_before_exit();
     BEGIN_TRY_L(exit) {
         TRY_L(exit) {
             os_sched_exit(-1);
@@ -130,7 +166,11 @@ __attribute__((section(".boot"))) int main(void) {
             USB_power(0);
             USB_power(1);
 
-            ui_idle();
+            if (dropped_entries != 0) {
+                ui_entries_dropped(dropped_entries);
+            } else {
+                ui_idle();
+            }
 
             app_main();
         }
@@ -1,120 +1,843 @@
 #include "metadata.h"
 #include "globals.h"
+#include "derivation_cache.h"
+#include "entry_index.h"
+#include "entry_usage.h"
+#include "nickname_codec.h"
+#include "store_stats.h"
 
+/* offset past the last record, METADATA_END until the log is walked again */
+static uint32_t free_offset = METADATA_END;
+
+/* record the background compaction goes on from, METADATA_END when none is erased */
+static uint32_t compaction_cursor;
+/* ticker events since the last button press or command */
+static uint16_t idle_ticks;
+
+/* progress of the load into the inactive bank */
+static struct {
+    uint32_t received;
+    uint32_t next_record;  // first record not checked yet
+    bool ended;            // the end of the records was received
+    bool current;          // the records received are in the current format
+    size_t count;
+    uint32_t digest;
+    error_type_t err;
+} load;
+
+/* the background compaction looks for erased records again once it found none; those erased
+ * behind a pass are reached by the next one */
+static void wake_compaction(void) {
+    if (compaction_cursor == METADATA_END) {
+        compaction_cursor = 0;
+    }
+}
+
+/* CRC-8, polynomial 0x07 */
+static uint8_t crc8(uint8_t crc, const volatile uint8_t *bytes, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/* the kind, the group and the usage data are left out, they are updated in place */
+static uint8_t record_checksum(const volatile uint8_t *record) {
+    uint8_t crc = crc8(0, record, 1);
+    return crc8(crc, record + 2, 1 + RECORD_NICKNAME_LEN(record));
+}
+
+/* share of an entry in the digest of the store */
+static uint32_t record_digest(const volatile uint8_t *record) {
+    uint8_t checksum =
+        RECORD_IS_CHECKED(record) ? RECORD_CHECKSUM(record) : record_checksum(record);
+    return ((uint32_t) RECORD_DATALEN(record) << 8) | checksum;
+}
+
+/* whether the record can be read, and for checked records whether it matches its checksum */
+static error_type_t check_record(const volatile uint8_t *record, bool verify_checksum) {
+    if (RECORD_KIND(record) == META_ERASED) {
+        // erased records lost their kind, the length of their nickname is unknown
+        return OK;
+    }
+    uint8_t format = RECORD_FORMAT(record);
+    if ((format != META_NONE && format != META_EXTENDED && format != META_TAGGED) ||
+        RECORD_DATALEN(record) < 1 + RECORD_EXT_LEN(record)) {
+        return ERR_CORRUPTED_METADATA;
+    }
+    if (RECORD_DATALEN(record) - RECORD_EXT_LEN(record) >= 1 + MAX_METANAME) {
+        return ERR_METADATA_ENTRY_TOO_BIG;
+    }
+    if (verify_checksum && RECORD_IS_CHECKED(record) &&
+        RECORD_CHECKSUM(record) != record_checksum(record)) {
+        return ERR_CORRUPTED_METADATA;
+    }
+    return OK;
+}
+
+/* offset of a field of the header from the active bank */
+#define HEADER_OFFSET(field) \
+    (offsetof(internalStorage_t, field) - offsetof(internalStorage_t, active_bank))
+
+/* whether the record is in the format append_metadata() writes, or needs a migration */
+static bool is_current_record(const volatile uint8_t *record) {
+    return RECORD_FORMAT(record) != META_NONE &&
+           RECORD_IS_CHECKED(record) == (METADATA_CHECKSUM_LEN != 0);
+}
+
+/* the active bank, the format of its records, the entries count and the digest share a
+ * single write */
+static void write_header(uint8_t bank, uint8_t version, size_t count, uint32_t digest) {
+    uint8_t header[HEADER_OFFSET(metadata_digest) + sizeof(digest)];
+    os_memcpy(header, (const void *) &N_storage.active_bank, sizeof(header));
+    header[0] = bank;
+    header[HEADER_OFFSET(metadata_version)] = version;
+    os_memcpy(header + HEADER_OFFSET(metadata_count), &count, sizeof(count));
+    os_memcpy(header + HEADER_OFFSET(metadata_digest), &digest, sizeof(digest));
+    store_write((void *) &N_storage.active_bank, header, sizeof(header));
+}
+
+static void write_summary(size_t count, uint32_t digest) {
+    write_header(N_storage.active_bank, N_storage.metadata_version, count, digest);
+}
+
+/* records are appended at the end of the log, and the erased ones are only reclaimed once the
+ * free space runs out: the writes go around the whole store instead of rewriting its start */
 error_type_t write_metadata(uint8_t *data, uint8_t dataSize) {
+    // the nickname as it will be stored, cut to MAX_METANAME
+    uint8_t len = dataSize > MAX_METANAME ? MAX_METANAME : dataSize;
+    if (len != 0 && entry_index_find(data[0], (const char *) data + 1, len - 1) != METADATA_END) {
+        return ERR_DUPLICATE_METADATA;
+    }
+    metadata_ext_t ext;
+    os_memset(&ext, 0, sizeof(ext));
+    error_type_t err = append_metadata(data, dataSize, &ext, 0);
+    if (err == ERR_NO_MORE_SPACE_AVAILABLE) {
+        err = compact_metadata();
+        if (err == OK) {
+            err = append_metadata(data, dataSize, &ext, 0);
+        }
+    }
+    return err;
+}
+
+/* builds an extended record, a tagged record when the entry belongs to a group, with the
+ * nickname packed when that makes the record shorter; returns its length */
+static uint8_t build_record(uint8_t record[METADATA_MAX_RECORD_LEN],
+                            const uint8_t *data,
+                            uint8_t dataSize,
+                            const metadata_ext_t *ext,
+                            uint8_t group) {
     if (dataSize > MAX_METANAME) {
         dataSize = MAX_METANAME;
     }
-    error_type_t err = compact_metadata();
-    if (err) {
-        return err;
+    uint8_t kind = group != 0 ? META_TAGGED : META_EXTENDED;
+    if (METADATA_CHECKSUM_LEN != 0) {
+        kind |= META_FLAG_CHECKED;
+    }
+    os_memcpy(record + 2, data, dataSize);
+    uint8_t packed[MAX_METANAME];
+    uint8_t packed_len = dataSize > 1 ? nickname_pack((const char *) data + 1,
+                                                      dataSize - 1,
+                                                      packed,
+                                                      sizeof(packed))
+                                      : 0;
+    if (packed_len != 0) {
+        os_memcpy(record + 3, packed, packed_len);
+        dataSize = 1 + packed_len;
+        kind |= META_FLAG_PACKED;
+    }
+    record[0] = dataSize + METADATA_CHECKSUM_LEN + (group != 0 ? 1 : 0) + sizeof(*ext);
+    record[1] = kind;
+    uint8_t len = 2 + dataSize;
+    if (METADATA_CHECKSUM_LEN != 0) {
+        record[len++] = record_checksum(record);
     }
+    if (group != 0) {
+        record[len++] = group;
+    }
+    os_memcpy(record + len, ext, sizeof(*ext));
+    return len + sizeof(*ext);
+}
+
+/* writes a record after the last one, without compacting the previous ones */
+error_type_t append_metadata(uint8_t *data,
+                             uint8_t dataSize,
+                             const metadata_ext_t *ext,
+                             uint8_t group) {
+    uint8_t record[METADATA_MAX_RECORD_LEN + 2];
+    uint8_t len = build_record(record, data, dataSize, ext, group);
     uint32_t offset = find_free_metadata();
-    if ((offset + dataSize + 2 + 2) > MAX_METADATAS) {
+    if (offset + len + 2 > MAX_METADATAS) {
         return ERR_NO_MORE_SPACE_AVAILABLE;
     }
-    nvm_write((void *) &N_storage.metadatas[offset + 2], data, dataSize);
-    uint8_t tmp[2];
-    tmp[0] = 0;
-    tmp[1] = META_NONE;
-    nvm_write((void *) &N_storage.metadatas[offset + 2 + dataSize], tmp, 2);
-    tmp[0] = dataSize;
-    tmp[1] = META_NONE;
-    nvm_write((void *) &N_storage.metadatas[offset], tmp, 2);
-    size_t metadata_count = N_storage.metadata_count + 1;
-    nvm_write((void *) &N_storage.metadata_count, &metadata_count, 4);
+    // the record only shows once its header is written, after the new end of the log
+    record[len] = 0;
+    record[len + 1] = META_NONE;
+    store_write((void *) METADATA_PTR(offset + 2), record + 2, len);
+    store_write((void *) METADATA_PTR(offset), record, 2);
+    free_offset = offset + len;
+    write_summary(N_storage.metadata_count + 1,
+                  N_storage.metadata_digest + record_digest(METADATA_PTR(offset)));
+    entry_index_on_write(offset);
     return OK;
 }
 
+/* wipes both banks, the inactive one still holds the entries of the last compaction */
 void reset_metadatas(void) {
-    nvm_write((void *) N_storage.metadatas, NULL, sizeof(N_storage.metadatas));
+    derivation_cache_wipe();
+    entry_usage_discard();
+    store_write((void *) N_storage.metadata_banks, NULL, sizeof(N_storage.metadata_banks));
+    write_header(0, METADATA_VERSION, 0, 0);
+    free_offset = 0;
+    compaction_cursor = 0;
+    entry_index_build();
 }
 
 error_type_t erase_metadata(uint32_t offset) {
     if (N_storage.metadata_count == 0) {
         return ERR_NO_METADATA;
     }
-    size_t metadata_count = N_storage.metadata_count - 1;
+    derivation_cache_wipe();
+    uint32_t digest = N_storage.metadata_digest - record_digest(METADATA_PTR(offset));
     unsigned char m = META_ERASED;
-    nvm_write((void *) &N_storage.metadatas[offset + 1], &m, 1);
-    nvm_write((void *) &N_storage.metadata_count, &metadata_count, 4);
+    store_write((void *) METADATA_PTR(offset + 1), &m, 1);
+    wake_compaction();
+    write_summary(N_storage.metadata_count - 1, digest);
+    entry_index_on_erase(offset);
     return OK;
 }
 
-uint32_t find_free_metadata(void) {
-    uint32_t offset = 0;
-    while ((METADATA_DATALEN(offset) != 0) && (offset < MAX_METADATAS)) {
-        offset += METADATA_TOTAL_LEN(offset);
+/* erases several records with a single count update, they are reclaimed by the next
+ * compaction */
+error_type_t erase_metadatas(const uint16_t *offsets, uint16_t count) {
+    if (count > N_storage.metadata_count) {
+        return ERR_NO_METADATA;
+    }
+    derivation_cache_wipe();
+    uint32_t digest = N_storage.metadata_digest;
+    unsigned char m = META_ERASED;
+    for (uint16_t i = 0; i < count; i++) {
+        digest -= record_digest(METADATA_PTR(offsets[i]));
+        store_write((void *) METADATA_PTR(offsets[i] + 1), &m, 1);
+    }
+    wake_compaction();
+    write_summary(N_storage.metadata_count - count, digest);
+    for (uint16_t i = 0; i < count; i++) {
+        entry_index_on_erase(offsets[i]);
+    }
+    return OK;
+}
+
+uint16_t erase_duplicate_metadatas(void) {
+    uint16_t duplicates[32];
+    uint16_t count = 0;
+    uint16_t erased = 0;
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset)) {
+        char nickname[MAX_METANAME + 1];
+        uint8_t len = get_metadata_nickname(offset, nickname);
+        // the earlier entries are kept, so the first one found is never erased
+        if (entry_index_find(METADATA_SETS(offset), nickname, len) != offset) {
+            duplicates[count++] = offset;
+        }
+        if (count == sizeof(duplicates) / sizeof(duplicates[0])) {
+            erase_metadatas(duplicates, count);
+            erased += count;
+            count = 0;
+        }
+    }
+    if (count != 0) {
+        erase_metadatas(duplicates, count);
+        erased += count;
+    }
+    return erased;
+}
+
+/* tagged records are updated in place, the others are rewritten as tagged records */
+error_type_t set_metadata_group(uint32_t offset, uint8_t group) {
+    if (METADATA_FORMAT(offset) == META_TAGGED) {
+        store_write((void *) METADATA_GROUP_PTR(offset), &group, 1);
+        entry_index_on_group_change(offset);
+        return OK;
+    }
+    uint8_t data[1 + MAX_METANAME + 1];
+    data[0] = METADATA_SETS(offset);
+    uint8_t data_len = 1 + get_metadata_nickname(offset, (char *) data + 1);
+    metadata_ext_t ext;
+    // with the usage data not written yet, the pending copy is left to the erased record
+    entry_usage_get(offset, &ext);
+    // the copy is written first: an interruption leaves a duplicate, never a lost entry
+    error_type_t err = append_metadata(data, data_len, &ext, group);
+    if (err == ERR_NO_MORE_SPACE_AVAILABLE) {
+        // reclaiming the erased records moves the entry, and the usage data it writes first can
+        // move legacy records to the end of the log, the entry itself included: it is found
+        // again by its charsets and nickname
+        err = compact_metadata();
+        if (err == OK) {
+            offset = entry_index_find(data[0], (const char *) data + 1, data_len - 1);
+            err = offset != METADATA_END ? append_metadata(data, data_len, &ext, group)
+                                         : ERR_NO_METADATA;
+        }
+    }
+    if (err != OK) {
+        return err;
+    }
+    return erase_metadata(offset);
+}
+
+/* copies the nickname of the record, unpacked and null terminated, returns its length */
+uint8_t get_metadata_nickname(uint32_t offset, char nickname[MAX_METANAME + 1]) {
+    uint8_t len = METADATA_NICKNAME_LEN(offset);
+    if (METADATA_IS_PACKED(offset)) {
+        len = nickname_unpack(METADATA_NICKNAME(offset), len, nickname, MAX_METANAME);
+    } else {
+        os_memcpy(nickname, (const void *) METADATA_NICKNAME(offset), len);
+    }
+    nickname[len] = '\0';
+    return len;
+}
+
+/* offset itself when a record starts there, METADATA_END otherwise */
+static uint32_t record_at(uint32_t offset) {
+    if (offset + 2 > MAX_METADATAS || METADATA_DATALEN(offset) == 0 ||
+        offset + METADATA_TOTAL_LEN(offset) > MAX_METADATAS) {
+        return METADATA_END;
+    }
+    return offset;
+}
+
+/* offset itself when a record starts there and is erased or passes its checksum, METADATA_END
+ * otherwise: the length of a record which fails its checksum can't be trusted */
+static uint32_t readable_record_at(uint32_t offset) {
+    if (record_at(offset) == METADATA_END ||
+        (METADATA_KIND(offset) != META_ERASED &&
+         check_record(METADATA_PTR(offset), true) != OK)) {
+        return METADATA_END;
     }
     return offset;
 }
 
+uint32_t metadata_first(void) {
+    return record_at(0);
+}
+
+uint32_t metadata_next(uint32_t offset) {
+    return record_at(offset + METADATA_TOTAL_LEN(offset));
+}
+
+uint32_t metadata_first_entry(void) {
+    uint32_t offset = metadata_first();
+    return (offset != METADATA_END && METADATA_KIND(offset) == META_ERASED)
+               ? metadata_next_entry(offset)
+               : offset;
+}
+
+uint32_t metadata_next_entry(uint32_t offset) {
+    do {
+        offset = metadata_next(offset);
+    } while (offset != METADATA_END && METADATA_KIND(offset) == META_ERASED);
+    return offset;
+}
+
+/* the free space is only searched for after a compaction or a load */
+uint32_t find_free_metadata(void) {
+    if (free_offset == METADATA_END) {
+        free_offset = 0;
+        for (uint32_t offset = metadata_first(); offset != METADATA_END;
+             offset = metadata_next(offset)) {
+            free_offset = offset + METADATA_TOTAL_LEN(offset);
+        }
+    }
+    return free_offset;
+}
+
 uint32_t get_metadata(uint32_t nth) {
-    unsigned int offset = 0;
-    for (;;) {
-        if (METADATA_DATALEN(offset) == 0) {
-            return -1UL;  // end of file
+    if (entry_index_available()) {
+        return nth < entry_index_count() ? entry_index_offset(nth) : METADATA_END;
+    }
+    uint32_t offset = metadata_first_entry();
+    while (offset != METADATA_END && nth-- > 0) {
+        offset = metadata_next_entry(offset);
+    }
+    return offset;  // METADATA_END past the last entry
+}
+
+static uint16_t fletcher16(const volatile void *data, size_t len) {
+    const volatile uint8_t *bytes = (const volatile uint8_t *) data;
+    uint16_t sum_1 = 0;
+    uint16_t sum_2 = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum_1 = (sum_1 + bytes[i]) % 255;
+        sum_2 = (sum_2 + sum_1) % 255;
+    }
+    return (sum_2 << 8) | sum_1;
+}
+
+static uint16_t step_checksum(const volatile compaction_step_t *step) {
+    return fletcher16(step, offsetof(compaction_step_t, checksum));
+}
+
+/* empties the journal, the older step first so that a reset in between still finds the last
+ * one */
+static void clear_journal(uint32_t last_sequence) {
+    uint32_t sequence = 0;
+    store_write((void *) &N_storage.journal[(last_sequence + 1) % 2].sequence, &sequence, 4);
+    store_write((void *) &N_storage.journal[last_sequence % 2].sequence, &sequence, 4);
+}
+
+/* writes the step to the journal, in the slot of the step before the previous one, then
+ * writes its page */
+static void write_step(compaction_step_t *step) {
+    step->sequence++;
+    step->checksum = step_checksum(step);
+    store_write((void *) &N_storage.journal[step->sequence % 2], step, sizeof(*step));
+    store_write((void *) METADATA_PTR(step->destination), step->page, step->len);
+    step->destination += step->len;
+    step->len = 0;
+}
+
+static void push_byte(compaction_step_t *step, uint8_t byte) {
+    step->page[step->len++] = byte;
+    if ((uintptr_t) METADATA_PTR(step->destination + step->len) % METADATA_PAGE_SIZE == 0) {
+        write_step(step);
+    }
+}
+
+/* moves the records left from source to stop, skipping the erased ones; the bytes of the
+ * last page not full yet stay in step */
+static void move_bytes(compaction_step_t *step, uint32_t stop) {
+    while (step->source < stop) {
+        if (step->source == step->next_record) {
+            step->next_record += METADATA_TOTAL_LEN(step->source);
+            if (METADATA_KIND(step->source) == META_ERASED) {
+                step->source = step->next_record;
+                continue;
+            }
         }
-        if (METADATA_KIND(offset) != META_ERASED) {
-            if (nth == 0) {
-                return offset;
+        // the first bytes of a record may overwrite its own header, source is read once
+        push_byte(step, *METADATA_PTR(step->source++));
+    }
+}
+
+/* moves the records left from source to end, then declares the remaining space free */
+static void move_records(compaction_step_t *step) {
+    move_bytes(step, step->end);
+    push_byte(step, 0);
+    push_byte(step, META_NONE);
+    step->last = true;
+    if (step->len != 0) {
+        write_step(step);
+    }
+    clear_journal(step->sequence);
+}
+
+/* updates the entries count and the free space after records moved */
+static void count_metadatas(void) {
+    size_t count = 0;
+    free_offset = 0;
+    for (uint32_t offset = metadata_first(); offset != METADATA_END;
+         offset = metadata_next(offset)) {
+        free_offset = offset + METADATA_TOTAL_LEN(offset);
+        count++;
+    }
+    // the records moved unchanged, so did the digest
+    if (count != N_storage.metadata_count) {
+        write_summary(count, N_storage.metadata_digest);
+    }
+}
+
+bool recover_metadata(void) {
+    int last = -1;
+    for (int i = 0; i < 2; i++) {
+        const volatile compaction_step_t *slot = &N_storage.journal[i];
+        if (slot->sequence != 0 && slot->checksum == step_checksum(slot) &&
+            slot->len <= sizeof(slot->page) && slot->destination + slot->len <= MAX_METADATAS &&
+            slot->end <= MAX_METADATAS &&
+            (last < 0 || slot->sequence > N_storage.journal[last].sequence)) {
+            last = i;
+        }
+    }
+    if (last < 0) {
+        return false;
+    }
+    compaction_step_t step;
+    os_memcpy(&step, (const void *) &N_storage.journal[last], sizeof(step));
+    // the page write may have been interrupted, the moves go on from the following byte
+    store_write((void *) METADATA_PTR(step.destination), step.page, step.len);
+    step.destination += step.len;
+    step.len = 0;
+    if (!step.last) {
+        move_records(&step);
+    } else {
+        clear_journal(step.sequence);
+    }
+    count_metadatas();
+    return true;
+}
+
+uint16_t check_metadatas(bool full) {
+    uint32_t digest = 0;
+    size_t count = 0;
+    // the store may have been written behind the cached offsets
+    free_offset = METADATA_END;
+    compaction_cursor = 0;
+    if (!full) {
+        // only the stored checksums are read
+        for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+             offset = metadata_next_entry(offset)) {
+            if (check_record(METADATA_PTR(offset), false) != OK) {
+                break;
             }
-            nth--;
+            digest += record_digest(METADATA_PTR(offset));
+            count++;
+        }
+        if (digest == N_storage.metadata_digest && count == N_storage.metadata_count) {
+            return 0;
+        }
+    }
+    digest = 0;
+    count = 0;
+    uint32_t offset = 0;
+    while (readable_record_at(offset) != METADATA_END) {
+        if (METADATA_KIND(offset) != META_ERASED) {
+            digest += record_digest(METADATA_PTR(offset));
+            count++;
         }
         offset += METADATA_TOTAL_LEN(offset);
     }
+    uint16_t dropped = 0;
+    if (offset + 2 <= MAX_METADATAS && METADATA_DATALEN(offset) != 0) {
+        // the length of this record can't be trusted, nor the offsets of the following ones:
+        // the log ends here, the entries which seem to follow are only counted
+        dropped = 1;
+        for (uint32_t next = offset + METADATA_TOTAL_LEN(offset); record_at(next) != METADATA_END;
+             next += METADATA_TOTAL_LEN(next)) {
+            dropped += METADATA_KIND(next) != META_ERASED;
+        }
+        uint8_t end[2] = {0, META_NONE};
+        store_write((void *) METADATA_PTR(offset), end, 2);
+        derivation_cache_wipe();
+        entry_usage_discard();
+    }
+    if (count != N_storage.metadata_count || digest != N_storage.metadata_digest) {
+        write_summary(count, digest);
+    }
+    return dropped;
 }
 
-error_type_t compact_metadata() {
-    uint32_t offset = 0;
-    uint32_t shift_offset = 0;
-    uint8_t copy_buffer[2 + 1 + MAX_METANAME];
-    while ((METADATA_DATALEN(offset) != 0) && (offset < MAX_METADATAS)) {
-        if (METADATA_TOTAL_LEN(offset) >= sizeof(copy_buffer)) {
-            return ERR_METADATA_ENTRY_TOO_BIG;
-        }
-        switch (METADATA_KIND(offset)) {
-            case META_NONE:
-                if (shift_offset != 0) {
-                    os_memcpy(copy_buffer,
-                              (const void *) METADATA_PTR(offset),
-                              METADATA_TOTAL_LEN(offset));
-                    nvm_write((void *) &N_storage.metadatas[shift_offset],
-                              copy_buffer,
-                              METADATA_TOTAL_LEN(offset));
-                    offset += METADATA_TOTAL_LEN(shift_offset);
-                    shift_offset += METADATA_TOTAL_LEN(shift_offset);
-                } else {
-                    offset += METADATA_TOTAL_LEN(offset);
-                }
-                break;
-            case META_ERASED:
-                shift_offset = shift_offset == 0 ? offset : shift_offset;
-                offset += METADATA_TOTAL_LEN(offset);
-                break;
+void start_metadatas_load(void) {
+    os_memset(&load, 0, sizeof(load));
+    load.current = true;
+}
 
-            default:
-                return ERR_CORRUPTED_METADATA;
+error_type_t write_metadatas_chunk(const uint8_t *bytes, size_t len) {
+    volatile uint8_t *bank = N_storage.metadata_banks[METADATA_BANK ^ 1];
+    if (len > MAX_METADATAS - load.received) {
+        return ERR_NO_MORE_SPACE_AVAILABLE;
+    }
+    store_write((void *) &bank[load.received], (void *) bytes, len);
+    load.received += len;
+    // the records received whole are checked, the bytes after the end of the records ignored
+    while (load.err == OK && !load.ended && load.next_record < load.received) {
+        const volatile uint8_t *record = &bank[load.next_record];
+        if (RECORD_DATALEN(record) == 0) {
+            load.ended = true;
+        } else if (load.next_record + 2 + RECORD_DATALEN(record) <= load.received) {
+            load.err = check_record(record, true);
+            if (RECORD_KIND(record) != META_ERASED) {
+                load.digest += record_digest(record);
+                load.count++;
+                load.current = load.current && is_current_record(record);
+            }
+            load.next_record += 2 + RECORD_DATALEN(record);
+        } else {
+            break;
         }
     }
-    if (shift_offset >= MAX_METADATAS || offset >= MAX_METADATAS) {
-        return ERR_NO_MORE_SPACE_AVAILABLE;
+    return load.err;
+}
+
+error_type_t commit_metadatas_load(void) {
+    if (load.err == OK && !load.ended && load.next_record != load.received) {
+        // the last record was cut
+        load.err = ERR_CORRUPTED_METADATA;
     }
-    // declare that the remaining space is free
-    if (shift_offset != 0) {
-        copy_buffer[0] = 0;
-        copy_buffer[1] = META_NONE;
-        nvm_write((void *) &N_storage.metadatas[shift_offset], copy_buffer, 2);
+    if (load.err != OK) {
+        return load.err;
     }
-    // count metadatas
-    offset = 0;
-    size_t count = 0;
+    uint8_t bank = METADATA_BANK ^ 1;
+    if (!load.ended && load.next_record < MAX_METADATAS) {
+        uint8_t end[2] = {0, META_NONE};
+        store_write((void *) &N_storage.metadata_banks[bank][load.next_record],
+                    end,
+                    load.next_record + 2 <= MAX_METADATAS ? 2 : 1);
+    }
+    derivation_cache_wipe();
+    // pending usage data refers to the records being replaced
+    entry_usage_discard();
+    // older records are converted by migrate_metadatas() when the app starts again
+    write_header(bank, load.current ? METADATA_VERSION : 0, load.count, load.digest);
+    free_offset = METADATA_END;
+    compaction_cursor = 0;
+    return OK;
+}
+
+error_type_t compact_metadata() {
+    uint32_t offset = 0;
+    uint32_t first_erased = METADATA_END;
+    // records are about to move, pending usage data is addressed by offset
+    entry_usage_flush();
+    free_offset = METADATA_END;
+    // every record is checked before any is moved
     while ((METADATA_DATALEN(offset) != 0) && (offset < MAX_METADATAS)) {
+        error_type_t err = check_record(METADATA_PTR(offset), false);
+        if (err != OK) {
+            return err;
+        }
+        if (METADATA_KIND(offset) == META_ERASED && first_erased == METADATA_END) {
+            first_erased = offset;
+        }
         offset += METADATA_TOTAL_LEN(offset);
-        count++;
     }
-    nvm_write((void *) &N_storage.metadata_count,
-              (void *) &count,
-              sizeof(N_storage.metadata_count));
+    if (offset >= MAX_METADATAS) {
+        return ERR_NO_MORE_SPACE_AVAILABLE;
+    }
+    // the records following the first erased one move down
+    if (first_erased != METADATA_END) {
+        compaction_step_t step;
+        os_memset(&step, 0, sizeof(step));
+        step.destination = first_erased;
+        step.source = first_erased;
+        step.next_record = first_erased;
+        step.end = offset;
+        move_records(&step);
+        entry_index_on_compact();
+        store_stats_on_compaction();
+    }
+    count_metadatas();
+    compaction_cursor = METADATA_END;
     return OK;
-}
\ No newline at end of file
+}
+
+/* declares the len bytes at offset erased, as records of up to 257 bytes */
+static void write_erased_records(uint32_t offset, uint32_t len) {
+    while (len != 0) {
+        // a record is at least 3 bytes long
+        uint32_t record_len = len <= 257 ? len : (len - 257 >= 3 ? 257 : len - 3);
+        uint8_t header[2] = {(uint8_t) (record_len - 2), META_ERASED};
+        store_write((void *) METADATA_PTR(offset), header, 2);
+        offset += record_len;
+        len -= record_len;
+    }
+}
+
+bool compact_metadata_step(void) {
+    if (compaction_cursor == METADATA_END) {
+        return false;
+    }
+    // records are about to move, pending usage data is addressed by offset
+    entry_usage_flush();
+    uint32_t hole = compaction_cursor;
+    while (record_at(hole) != METADATA_END && METADATA_KIND(hole) != META_ERASED) {
+        hole += METADATA_TOTAL_LEN(hole);
+    }
+    if (record_at(hole) == METADATA_END) {
+        // records erased during the pass are before its start
+        compaction_cursor = compaction_cursor == 0 ? METADATA_END : 0;
+        return compaction_cursor == 0;
+    }
+    uint32_t source = hole;
+    while (record_at(source) != METADATA_END && METADATA_KIND(source) == META_ERASED) {
+        source += METADATA_TOTAL_LEN(source);
+    }
+    if (record_at(source) == METADATA_END) {
+        if (source + 2 <= MAX_METADATAS && METADATA_DATALEN(source) != 0) {
+            // a record overflows the store, compact_metadata() reports it
+            compaction_cursor = METADATA_END;
+            return false;
+        }
+        // only erased records left, the free space starts at the first one
+        uint8_t end[2] = {0, META_NONE};
+        store_write((void *) METADATA_PTR(hole), end, 2);
+        free_offset = hole;
+        compaction_cursor = 0;
+        store_stats_on_compaction();
+        return true;
+    }
+    // the live records following the erased ones move over them, at least one
+    uint32_t stop = source;
+    do {
+        if (check_record(METADATA_PTR(stop), false) != OK) {
+            compaction_cursor = METADATA_END;
+            return false;
+        }
+        stop += METADATA_TOTAL_LEN(stop);
+    } while (record_at(stop) != METADATA_END && METADATA_KIND(stop) != META_ERASED &&
+             stop + METADATA_TOTAL_LEN(stop) - source <= COMPACTION_STEP_BYTES);
+    compaction_step_t step;
+    os_memset(&step, 0, sizeof(step));
+    step.destination = hole;
+    step.source = source;
+    step.next_record = source;
+    // completed by recover_metadata() as a whole compaction if interrupted
+    step.end = find_free_metadata();
+    move_bytes(&step, stop);
+    if (step.len != 0) {
+        write_step(&step);
+    }
+    // the erased space now follows the moved records
+    write_erased_records(step.destination, source - hole);
+    clear_journal(step.sequence);
+    compaction_cursor = step.destination;
+    entry_index_on_compact();
+    return true;
+}
+
+void compaction_postpone(void) {
+    idle_ticks = 0;
+}
+
+void compaction_on_ticker(void) {
+    if (idle_ticks < COMPACTION_IDLE_TICKS) {
+        idle_ticks++;
+        return;
+    }
+    // a dump reads the store by offset over several commands
+    if (app_state.current_command == DUMP_METADATAS && app_state.user_approval) {
+        return;
+    }
+    // records are only moved when the space is about to run out, like compact_metadata()
+    if (MAX_METADATAS - find_free_metadata() < COMPACTION_FREE_SPACE) {
+        compact_metadata_step();
+    }
+}
+
+/* converts the live record at offset to the next format, returns the length of the converted
+ * record, 0 to drop it */
+typedef uint8_t (*record_migration_t)(uint32_t offset, uint8_t record[METADATA_MAX_RECORD_LEN]);
+
+/* version 0 to 1: records are written again as append_metadata() writes them */
+static uint8_t migrate_to_v1(uint32_t offset, uint8_t record[METADATA_MAX_RECORD_LEN]) {
+    uint8_t data[1 + MAX_METANAME + 1];
+    data[0] = METADATA_SETS(offset);
+    uint8_t data_len = 1 + get_metadata_nickname(offset, (char *) data + 1);
+    if (is_current_record(METADATA_PTR(offset)) || data_len > MAX_METANAME) {
+        // written again, a nickname unpacking longer than a typed one would be cut
+        os_memcpy(record, (const void *) METADATA_PTR(offset), METADATA_TOTAL_LEN(offset));
+        return METADATA_TOTAL_LEN(offset);
+    }
+    metadata_ext_t ext;
+    os_memset(&ext, 0, sizeof(ext));
+    if (METADATA_HAS_EXT(offset)) {
+        os_memcpy(&ext, METADATA_EXT(offset), sizeof(ext));
+    }
+    // unknown groups are kept, as they are when read
+    uint8_t group = METADATA_FORMAT(offset) == META_TAGGED ? *METADATA_GROUP_PTR(offset) : 0;
+    return build_record(record, data, data_len, &ext, group);
+}
+
+/* MIGRATIONS[n] converts the records from version n to version n + 1 */
+static const record_migration_t MIGRATIONS[METADATA_VERSION] = {migrate_to_v1};
+
+/* erased records are dropped; the log is only converted up to its first unreadable record, as
+ * check_metadatas() cuts it there */
+static uint8_t migrate_record(record_migration_t migrate,
+                              uint32_t offset,
+                              uint8_t record[METADATA_MAX_RECORD_LEN]) {
+    if (METADATA_KIND(offset) == META_ERASED) {
+        return 0;
+    }
+    return migrate(offset, record);
+}
+
+/* whether the converted records and the end marker fit in a bank */
+static bool migration_fits(record_migration_t migrate) {
+    uint8_t record[METADATA_MAX_RECORD_LEN];
+    uint32_t size = 0;
+    for (uint32_t offset = readable_record_at(0); offset != METADATA_END;
+         offset = readable_record_at(offset + METADATA_TOTAL_LEN(offset))) {
+        size += migrate_record(migrate, offset, record);
+    }
+    return size + 2 <= MAX_METADATAS;
+}
+
+static void write_progress(migration_progress_t *progress) {
+    progress->checksum = fletcher16(progress, offsetof(migration_progress_t, checksum));
+    store_write((void *) &N_storage.migration, progress, sizeof(*progress));
+}
+
+/* converts the records from progress->source on to the other bank, a batch of records at a
+ * time, then makes this bank active */
+static void migrate_records(migration_progress_t *progress) {
+    record_migration_t migrate = (record_migration_t) PIC(MIGRATIONS[progress->version - 1]);
+    volatile uint8_t *bank = N_storage.metadata_banks[METADATA_BANK ^ 1];
+    uint8_t batch[METADATA_PAGE_SIZE];
+    uint8_t len = 0;
+    for (uint32_t offset = readable_record_at(progress->source); offset != METADATA_END;
+         offset = readable_record_at(offset + METADATA_TOTAL_LEN(offset))) {
+        uint8_t record[METADATA_MAX_RECORD_LEN];
+        uint8_t record_len = migrate_record(migrate, offset, record);
+        if (len + record_len > sizeof(batch)) {
+            store_write((void *) &bank[progress->destination], batch, len);
+            progress->destination += len;
+            progress->source = offset;
+            len = 0;
+            write_progress(progress);
+        }
+        os_memcpy(batch + len, record, record_len);
+        len += record_len;
+        if (record_len != 0) {
+            progress->digest += record_digest(record);
+            progress->count++;
+        }
+    }
+    if (len + 2 > sizeof(batch)) {
+        store_write((void *) &bank[progress->destination], batch, len);
+        progress->destination += len;
+        len = 0;
+    }
+    batch[len++] = 0;
+    batch[len++] = META_NONE;
+    store_write((void *) &bank[progress->destination], batch, len);
+    write_header(METADATA_BANK ^ 1, progress->version, progress->count, progress->digest);
+    uint8_t none = 0;
+    store_write((void *) &N_storage.migration.version, &none, 1);
+    free_offset = METADATA_END;
+    compaction_cursor = 0;
+}
+
+bool migrate_metadatas(void) {
+    migration_progress_t progress;
+    os_memcpy(&progress, (const void *) &N_storage.migration, sizeof(progress));
+    bool resume = progress.version != 0 && progress.version == N_storage.metadata_version + 1 &&
+                  progress.checksum ==
+                      fletcher16(&progress, offsetof(migration_progress_t, checksum)) &&
+                  progress.source < MAX_METADATAS && progress.destination < MAX_METADATAS;
+    if (progress.version != 0 && !resume) {
+        // completed before the progress was cleared, or torn: started again
+        uint8_t none = 0;
+        store_write((void *) &N_storage.migration.version, &none, 1);
+    }
+    bool migrated = false;
+    while (N_storage.metadata_version < METADATA_VERSION) {
+        if (!resume) {
+            if (!migration_fits(
+                    (record_migration_t) PIC(MIGRATIONS[N_storage.metadata_version]))) {
+                // the records are read in any format, they are converted once there is room
+                break;
+            }
+            os_memset(&progress, 0, sizeof(progress));
+            progress.version = N_storage.metadata_version + 1;
+        }
+        // pending usage data is addressed by offset
+        entry_usage_flush();
+        migrate_records(&progress);
+        resume = false;
+        migrated = true;
+    }
+    return migrated;
+}
@@ -2,33 +2,190 @@
 #define __METADATA_H__
 
 #include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
 
-#define METADATA_PTR(offset)       (&N_storage.metadatas[offset])
+/* fields of a record from its address, in either bank */
+#define RECORD_DATALEN(record) (record)[0]  // charsets(1) + pwd seed(n)
+#define RECORD_KIND(record)    (record)[1]
+/* kind of the record without the packed nickname and checksum flags */
+#define RECORD_FORMAT(record)          \
+    (RECORD_KIND(record) == META_ERASED \
+         ? META_ERASED                  \
+         : RECORD_KIND(record) & ~(META_FLAG_PACKED | META_FLAG_CHECKED))
+#define RECORD_IS_CHECKED(record) \
+    (RECORD_KIND(record) != META_ERASED && (RECORD_KIND(record) & META_FLAG_CHECKED))
+/* extended records end with a metadata_ext_t after the nickname, tagged records with the
+ * group of the entry then a metadata_ext_t; checked records have their checksum first */
+#define RECORD_EXT_LEN(record)                                             \
+    ((RECORD_FORMAT(record) == META_EXTENDED ? sizeof(metadata_ext_t)      \
+      : RECORD_FORMAT(record) == META_TAGGED ? sizeof(metadata_ext_t) + 1 \
+                                             : 0) +                        \
+     (RECORD_IS_CHECKED(record) ? 1 : 0))
+/* checksum of the length, charsets and stored nickname of a checked record */
+#define RECORD_CHECKSUM(record) (record)[2 + RECORD_DATALEN(record) - RECORD_EXT_LEN(record)]
+/* stored length of the nickname, packed or not; even if the database is corrupted, this
+ * garantees we never overflow buffers of size MAX_METANAME */
+#define RECORD_NICKNAME_LEN(record) \
+    ((uint8_t) (RECORD_DATALEN(record) - 1 - RECORD_EXT_LEN(record)) % (MAX_METANAME + 1))
+
+/* records of the active bank, the other one receives the loads */
+#define METADATA_BANK        (N_storage.active_bank & 1)
+#define METADATA_PTR(offset) (&N_storage.metadata_banks[METADATA_BANK][offset])
 #define METADATA_TOTAL_LEN(offset) (METADATA_DATALEN(offset) + 2)
-#define METADATA_DATALEN(offset)   N_storage.metadatas[offset]  // charsets(1) + pwd seed(n)
-#define METADATA_KIND(offset)      N_storage.metadatas[offset + 1]
-#define METADATA_SETS(offset)      N_storage.metadatas[offset + 2]
-/* even if the database is corrupted, this garantees we never overflow buffers of size
- * MAX_METANAME */
-#define METADATA_NICKNAME_LEN(offset) ((METADATA_DATALEN(offset) - 1) % (MAX_METANAME + 1))
-#define METADATA_NICKNAME(offset)     (&N_storage.metadatas[offset + 3])
+#define METADATA_DATALEN(offset)   RECORD_DATALEN(METADATA_PTR(offset))
+#define METADATA_KIND(offset)      RECORD_KIND(METADATA_PTR(offset))
+#define METADATA_SETS(offset)      METADATA_PTR(offset)[2]
+#define METADATA_FORMAT(offset)    RECORD_FORMAT(METADATA_PTR(offset))
+#define METADATA_IS_PACKED(offset) \
+    (METADATA_KIND(offset) != META_ERASED && (METADATA_KIND(offset) & META_FLAG_PACKED))
+#define METADATA_IS_CHECKED(offset) RECORD_IS_CHECKED(METADATA_PTR(offset))
+#define METADATA_HAS_EXT(offset) \
+    (METADATA_FORMAT(offset) == META_EXTENDED || METADATA_FORMAT(offset) == META_TAGGED)
+#define METADATA_EXT_LEN(offset)  RECORD_EXT_LEN(METADATA_PTR(offset))
+#define METADATA_CHECKSUM(offset) RECORD_CHECKSUM(METADATA_PTR(offset))
+#define METADATA_EXT(offset)                                                 \
+    ((metadata_ext_t *) METADATA_PTR(offset + 2 + METADATA_DATALEN(offset) - \
+                                     sizeof(metadata_ext_t)))
+#define METADATA_GROUP_PTR(offset) \
+    METADATA_PTR(offset + 2 + METADATA_DATALEN(offset) - sizeof(metadata_ext_t) - 1)
+/* group of the entry, unknown groups read as no group (0) but are kept in the record */
+#define METADATA_GROUP(offset)                                                                 \
+    ((METADATA_FORMAT(offset) == META_TAGGED && *METADATA_GROUP_PTR(offset) < METADATA_GROUPS) \
+         ? *METADATA_GROUP_PTR(offset)                                                         \
+         : 0)
+#define METADATA_NICKNAME_LEN(offset) RECORD_NICKNAME_LEN(METADATA_PTR(offset))
+/* stored nickname, get_metadata_nickname() unpacks it */
+#define METADATA_NICKNAME(offset) METADATA_PTR(offset + 3)
+
+/*
+ * Format of the records, kept in N_storage.metadata_version:
+ *   0: written before the format was kept, or loaded from a backup, any kind of record
+ *   1: extended or tagged records only, nicknames packed when shorter, with a checksum when
+ *      built with HAVE_RECORD_CHECKSUMS
+ * A new format adds its conversion to the migrations in metadata.c.
+ */
+#define METADATA_VERSION 1
+
+/* longest record written, a tagged and checked record with an unpacked nickname */
+#define METADATA_MAX_RECORD_LEN (2 + MAX_METANAME + 2 + sizeof(metadata_ext_t))
+
+/* ticker events (100ms) without a button press or a command before the background compaction
+ * starts */
+#define COMPACTION_IDLE_TICKS 20
+/* bytes of records moved by a step of the background compaction, about a page write */
+#define COMPACTION_STEP_BYTES METADATA_PAGE_SIZE
+/* free space under which the background compaction runs */
+#define COMPACTION_FREE_SPACE (MAX_METADATAS / 8)
+
+/* upper bound on the number of entries: the smallest record is 3 bytes long */
+#define MAX_METADATA_ENTRIES (MAX_METADATAS / 3)
+
+/* the entry index and the marked entries keep offsets on 16 bits */
+#if MAX_METADATAS > 0x10000
+#error "MAX_METADATAS must not exceed 64 KB"
+#endif
+
+/* returned by the iterators past the last record */
+#define METADATA_END ((uint32_t) -1)
+
+#define META_NONE     0x00
+#define META_EXTENDED 0x01
+#define META_TAGGED   0x02
+#define META_ERASED   0xFF
+/* set on extended and tagged records whose nickname is packed, see nickname_codec.h */
+#define META_FLAG_PACKED 0x10
+/* set on records followed by the checksum of their nickname */
+#define META_FLAG_CHECKED 0x20
+
+/* checksum bytes of the records written */
+#ifdef HAVE_RECORD_CHECKSUMS
+#define METADATA_CHECKSUM_LEN 1
+#else
+#define METADATA_CHECKSUM_LEN 0
+#endif
+
+#define EXT_FLAG_FAVOURITE 0x01
+
+/* groups an entry can be tagged with, group 0 being no group */
+#define METADATA_GROUPS 8
 
-#define META_NONE   0x00
-#define META_ERASED 0xFF
+/* usage data of an extended record, updated in place */
+typedef struct metadata_ext_s {
+    uint8_t flags;
+    uint8_t uses;          // saturates at 255
+    uint8_t last_used[2];  // big endian, compared to the other entries only
+} metadata_ext_t;
 
 typedef enum error_type_e {
     OK = 0,
     ERR_NO_MORE_SPACE_AVAILABLE,
     ERR_CORRUPTED_METADATA,
     ERR_NO_METADATA,
-    ERR_METADATA_ENTRY_TOO_BIG
+    ERR_METADATA_ENTRY_TOO_BIG,
+    ERR_DUPLICATE_METADATA
 } error_type_t;
 
+/* fails with ERR_DUPLICATE_METADATA when an entry has the same charsets and nickname */
 error_type_t write_metadata(uint8_t *data, uint8_t dataSize);
+error_type_t append_metadata(uint8_t *data,
+                             uint8_t dataSize,
+                             const metadata_ext_t *ext,
+                             uint8_t group);
 void reset_metadatas(void);
 error_type_t erase_metadata(uint32_t offset);
+error_type_t erase_metadatas(const uint16_t *offsets, uint16_t count);
+/* erases the entries with the same charsets and nickname as an earlier entry, returns their
+ * number; the entry index must be up to date */
+uint16_t erase_duplicate_metadatas(void);
+error_type_t set_metadata_group(uint32_t offset, uint8_t group);
+uint8_t get_metadata_nickname(uint32_t offset, char nickname[MAX_METANAME + 1]);
+/*
+ * Iterators over the records in log order, which stop at the free space and at any record
+ * overflowing the store:
+ *     for (offset = metadata_first(); offset != METADATA_END; offset = metadata_next(offset))
+ * The entry variants skip the erased records.
+ */
+uint32_t metadata_first(void);
+uint32_t metadata_next(uint32_t offset);
+uint32_t metadata_first_entry(void);
+uint32_t metadata_next_entry(uint32_t offset);
 uint32_t find_free_metadata(void);
 uint32_t get_metadata(uint32_t nth);
 error_type_t compact_metadata();
+/*
+ * Background compaction: once the device was left alone for COMPACTION_IDLE_TICKS with less
+ * than COMPACTION_FREE_SPACE left, each ticker event moves the live records following the first
+ * erased ones over them, COMPACTION_STEP_BYTES at most, and leaves the erased space after them:
+ * the store stays valid between steps, and a write seldom has to compact. Each step is
+ * journaled like compact_metadata(). Returns false once there is nothing left to reclaim; the
+ * entries keep their order but move, as after compact_metadata().
+ */
+bool compact_metadata_step(void);
+/* called on each button press and command */
+void compaction_postpone(void);
+void compaction_on_ticker(void);
+/*
+ * Checks the digest of the store, kept with the entries count, against the checksums of the
+ * records; when it differs, or when full is set, every record is checked against its checksum.
+ * As the length of a corrupted record can't be trusted, the log is cut at the first one, and
+ * the count and digest are computed again. Returns the number of entries dropped, the entry
+ * index must then be rebuilt.
+ */
+uint16_t check_metadatas(bool full);
+/* converts the records to METADATA_VERSION, or goes on with a migration interrupted by a reset;
+ * returns false if there was nothing to convert. The entry index must then be rebuilt. */
+bool migrate_metadatas(void);
+/*
+ * Bulk loads are written to the inactive bank and checked as the records arrive, the bank
+ * only becomes active once the load is committed: an interrupted or rejected load leaves the
+ * records as they were. A chunk returns the first error found so far.
+ */
+void start_metadatas_load(void);
+error_type_t write_metadatas_chunk(const uint8_t *bytes, size_t len);
+error_type_t commit_metadatas_load(void);
+/* completes a compaction interrupted by a reset, from its journal, returns false if there was
+ * none; it only moves the records the compaction had left, without checking the others */
+bool recover_metadata(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "nickname_codec.h"
+
+#include "os.h"
+#include "string.h"
+
+#define SYMBOL_BITS   6
+#define FIRST_DIGIT   26
+#define FIRST_SYMBOL  36
+#define FIRST_TOKEN   41
+#define ESCAPE        63
+#define TOKENS_COUNT  (ESCAPE - FIRST_TOKEN)
+#define MAX_TOKEN_LEN 7
+
+static const char SYMBOLS[] = ".-_@ ";
+
+/* parts found in many nicknames, the longest match is used */
+static const char TOKENS[TOKENS_COUNT][MAX_TOKEN_LEN + 1] = {
+    ".com", ".org",  ".net",  ".io",    ".fr",   ".de",   ".co.uk", ".ch",
+    "www.", "mail",  "admin", "bank",   "home",  "work",  "login",  "server",
+    "cloud", "account", "google", "micro", "online", "shop",
+};
+
+typedef struct bit_writer_s {
+    uint8_t *bytes;
+    uint8_t size;
+    uint16_t bits;
+} bit_writer_t;
+
+static bool write_bits(bit_writer_t *writer, uint8_t value, uint8_t count) {
+    if (writer->bits + count > writer->size * 8) {
+        return false;
+    }
+    for (int8_t i = count - 1; i >= 0; i--) {
+        uint8_t mask = 0x80 >> (writer->bits % 8);
+        if (value & (1 << i)) {
+            writer->bytes[writer->bits / 8] |= mask;
+        } else {
+            writer->bytes[writer->bits / 8] &= ~mask;
+        }
+        writer->bits++;
+    }
+    return true;
+}
+
+static uint8_t read_bits(const volatile uint8_t *bytes, uint16_t *bit, uint8_t count) {
+    uint8_t value = 0;
+    for (uint8_t i = 0; i < count; i++, (*bit)++) {
+        value = (value << 1) | ((bytes[*bit / 8] >> (7 - *bit % 8)) & 1);
+    }
+    return value;
+}
+
+/* symbol of a single character, ESCAPE when it has none */
+static uint8_t char_symbol(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a';
+    }
+    if (c >= '0' && c <= '9') {
+        return FIRST_DIGIT + c - '0';
+    }
+    const char *symbol = strchr(SYMBOLS, c);
+    return (c != '\0' && symbol != NULL) ? FIRST_SYMBOL + (symbol - SYMBOLS) : ESCAPE;
+}
+
+/* longest token at the start of text, TOKENS_COUNT when none matches */
+static uint8_t find_token(const char *text, uint8_t text_len, uint8_t *token_len) {
+    uint8_t best = TOKENS_COUNT;
+    *token_len = 0;
+    for (uint8_t t = 0; t < TOKENS_COUNT; t++) {
+        uint8_t len = strlen(TOKENS[t]);
+        if (len > *token_len && len <= text_len && memcmp(text, TOKENS[t], len) == 0) {
+            best = t;
+            *token_len = len;
+        }
+    }
+    return best;
+}
+
+uint8_t nickname_pack(const char *nickname,
+                      uint8_t nickname_len,
+                      uint8_t *packed,
+                      uint8_t packed_size) {
+    bit_writer_t writer = {packed, packed_size < nickname_len ? packed_size : nickname_len, 0};
+    uint8_t i = 0;
+    while (i < nickname_len) {
+        uint8_t token_len;
+        uint8_t token = find_token(nickname + i, nickname_len - i, &token_len);
+        bool written;
+        if (token != TOKENS_COUNT) {
+            written = write_bits(&writer, FIRST_TOKEN + token, SYMBOL_BITS);
+            i += token_len;
+        } else {
+            uint8_t symbol = char_symbol(nickname[i]);
+            written = write_bits(&writer, symbol, SYMBOL_BITS);
+            if (symbol == ESCAPE) {
+                written = written && write_bits(&writer, nickname[i], 8);
+            }
+            i++;
+        }
+        if (!written) {
+            return 0;  // not shorter than the nickname itself
+        }
+    }
+    uint8_t packed_len = (writer.bits + 7) / 8;
+    while (writer.bits % 8 != 0) {
+        write_bits(&writer, 1, 1);
+    }
+    return packed_len < nickname_len ? packed_len : 0;
+}
+
+uint8_t nickname_unpack(const volatile uint8_t *packed,
+                        uint8_t packed_len,
+                        char *nickname,
+                        uint8_t nickname_size) {
+    uint16_t bit = 0;
+    uint16_t total_bits = packed_len * 8;
+    uint8_t len = 0;
+    while (bit + SYMBOL_BITS <= total_bits && len < nickname_size) {
+        uint8_t symbol = read_bits(packed, &bit, SYMBOL_BITS);
+        if (symbol < FIRST_DIGIT) {
+            nickname[len++] = 'a' + symbol;
+        } else if (symbol < FIRST_SYMBOL) {
+            nickname[len++] = '0' + symbol - FIRST_DIGIT;
+        } else if (symbol < FIRST_TOKEN) {
+            nickname[len++] = SYMBOLS[symbol - FIRST_SYMBOL];
+        } else if (symbol < ESCAPE) {
+            const char *token = TOKENS[symbol - FIRST_TOKEN];
+            for (uint8_t i = 0; token[i] != '\0' && len < nickname_size; i++) {
+                nickname[len++] = token[i];
+            }
+        } else if (bit + 8 <= total_bits) {
+            nickname[len++] = read_bits(packed, &bit, 8);
+        } else {
+            break;  // padding
+        }
+    }
+    return len;
+}
@@ -0,0 +1,24 @@
+#ifndef __NICKNAME_CODEC_H__
+#define __NICKNAME_CODEC_H__
+
+#include "stdint.h"
+
+/*
+ * Packed nicknames: a stream of 6-bit symbols, most significant bits first, standing for a
+ * lowercase letter, a digit, one of ".-_@ ", a common nickname part such as ".com" or
+ * "mail", or an escape followed by any 8-bit character. The last byte is padded with 1 bits,
+ * which never decode to a complete symbol.
+ */
+
+/* packs the nickname, returns the packed length, or 0 when it would not be shorter */
+uint8_t nickname_pack(const char *nickname,
+                      uint8_t nickname_len,
+                      uint8_t *packed,
+                      uint8_t packed_size);
+/* unpacks at most nickname_size characters, not terminated, returns the nickname length */
+uint8_t nickname_unpack(const volatile uint8_t *packed,
+                        uint8_t packed_len,
+                        char *nickname,
+                        uint8_t nickname_size);
+
+#endif
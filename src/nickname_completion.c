@@ -0,0 +1,86 @@
+#include "nickname_completion.h"
+
+#include "os.h"
+#include "string.h"
+
+#include "globals.h"
+#include "metadata.h"
+#include "entry_usage.h"
+#include "domain_trie.h"
+
+static bool is_separator(char c) {
+    return c == ' ' || c == '@' || c == '/' || c == ':';
+}
+
+static char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/* length of the completion of word by the nickname word starting at start, 0 if none */
+static size_t complete_from_nickname(const char *nickname,
+                                     size_t nickname_len,
+                                     size_t start,
+                                     const char *word,
+                                     size_t word_len) {
+    size_t i = 0;
+    while (i < word_len && start + i < nickname_len &&
+           to_lower(nickname[start + i]) == to_lower(word[i])) {
+        i++;
+    }
+    if (i < word_len) {
+        return 0;
+    }
+    size_t end = start + i;
+    while (end < nickname_len && !is_separator(nickname[end])) {
+        end++;
+    }
+    return end - start - i;
+}
+
+static bool complete_from_entries(const char *word,
+                                  size_t word_len,
+                                  char *completion,
+                                  unsigned int completion_size) {
+    bool found = false;
+    uint16_t best_last_used = 0;
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset)) {
+        char nickname[MAX_METANAME + 1];
+        size_t nickname_len = get_metadata_nickname(offset, nickname);
+        for (size_t start = 0; start < nickname_len; start++) {
+            if (start > 0 && !is_separator(nickname[start - 1])) {
+                continue;
+            }
+            size_t len = complete_from_nickname(nickname, nickname_len, start, word, word_len);
+            uint16_t last_used = entry_usage_last_used(offset);
+            if (len == 0 || len >= completion_size || (found && last_used <= best_last_used)) {
+                continue;
+            }
+            memcpy(completion, &nickname[start + word_len], len);
+            completion[len] = '\0';
+            found = true;
+            best_last_used = last_used;
+        }
+    }
+    return found;
+}
+
+bool nickname_completion_find(const char *text, char *completion, unsigned int completion_size) {
+    size_t len = strlen(text);
+    size_t start = len;
+    while (start > 0 && !is_separator(text[start - 1])) {
+        start--;
+    }
+    const char *word = text + start;
+    size_t word_len = len - start;
+    if (word_len == 0 || completion_size == 0) {
+        return false;
+    }
+    if (complete_from_entries(word, word_len, completion, completion_size) ||
+        domain_trie_complete(word, word_len, completion, completion_size)) {
+        return true;
+    }
+    const char *dot = strrchr(word, '.');
+    return dot != NULL && dot != word &&
+           domain_trie_complete(dot, word + word_len - dot, completion, completion_size);
+}
@@ -0,0 +1,15 @@
+#ifndef __NICKNAME_COMPLETION_H__
+#define __NICKNAME_COMPLETION_H__
+
+#include "stdbool.h"
+
+/*
+ * Completion of the word being typed in a nickname, words being separated by ' ', '@', '/'
+ * or ':'. It is taken from the words of the existing nicknames first, most recently used
+ * entry first, then from the built-in dictionary of common domains, and last from its top
+ * level domains for the part following the last '.'. Matches the keyboard_completion_t
+ * prototype.
+ */
+bool nickname_completion_find(const char *text, char *completion, unsigned int completion_size);
+
+#endif
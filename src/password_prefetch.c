@@ -0,0 +1,76 @@
+#include "password_prefetch.h"
+
+#include "os.h"
+
+#include "password_typing.h"
+#include "derivation_cache.h"
+
+typedef enum { PREFETCH_EMPTY, PREFETCH_PENDING, PREFETCH_READY } prefetch_state_e;
+
+typedef struct prefetch_slot_s {
+    prefetch_state_e state;
+    uint16_t ticks;
+    uint8_t data_len;
+    uint8_t data[MAX_METANAME];
+    uint8_t seed[PASSWORD_SEED_LEN];
+} prefetch_slot_t;
+
+static prefetch_slot_t prefetch_slot;
+
+static bool prefetch_slot_matches(const uint8_t *data, uint32_t dataSize) {
+    return prefetch_slot.state != PREFETCH_EMPTY && prefetch_slot.data_len == dataSize &&
+           os_memcmp(prefetch_slot.data, data, dataSize) == 0;
+}
+
+void password_prefetch_wipe(void) {
+    os_memset(&prefetch_slot, 0, sizeof(prefetch_slot));
+}
+
+void password_prefetch_request(const uint8_t *data, uint32_t dataSize) {
+    if (dataSize > sizeof(prefetch_slot.data)) {
+        password_prefetch_wipe();
+        return;
+    }
+    if (prefetch_slot_matches(data, dataSize)) {
+        return;
+    }
+    // the user scrolled away, forget the previous entry
+    password_prefetch_wipe();
+    os_memcpy(prefetch_slot.data, data, dataSize);
+    prefetch_slot.data_len = dataSize;
+    prefetch_slot.state = PREFETCH_PENDING;
+}
+
+void password_prefetch_on_ticker(void) {
+    switch (prefetch_slot.state) {
+        case PREFETCH_PENDING:
+            if (++prefetch_slot.ticks >= PREFETCH_SETTLE_TICKS) {
+                if (!derivation_cache_get(prefetch_slot.data,
+                                          prefetch_slot.data_len,
+                                          prefetch_slot.seed)) {
+                    derive_password_seed(prefetch_slot.data,
+                                         prefetch_slot.data_len,
+                                         prefetch_slot.seed);
+                }
+                prefetch_slot.state = PREFETCH_READY;
+                prefetch_slot.ticks = 0;
+            }
+            break;
+        case PREFETCH_READY:
+            if (++prefetch_slot.ticks >= PREFETCH_TIMEOUT_TICKS) {
+                password_prefetch_wipe();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+bool password_prefetch_take(const uint8_t *data, uint32_t dataSize, uint8_t *seed) {
+    bool ready = prefetch_slot.state == PREFETCH_READY && prefetch_slot_matches(data, dataSize);
+    if (ready) {
+        os_memcpy(seed, prefetch_slot.seed, PASSWORD_SEED_LEN);
+    }
+    password_prefetch_wipe();
+    return ready;
+}
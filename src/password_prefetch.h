@@ -0,0 +1,21 @@
+#ifndef __PASSWORD_PREFETCH_H__
+#define __PASSWORD_PREFETCH_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/* ticker events (100ms) an entry must stay displayed before its seed is derived */
+#define PREFETCH_SETTLE_TICKS 3
+/* ticker events after which an unused derived seed is wiped */
+#define PREFETCH_TIMEOUT_TICKS 300
+
+/*
+ * Speculative derivation of the password seed of the entry currently displayed by the
+ * selection flow, so that confirming it does not wait for the BIP32 derivation.
+ */
+void password_prefetch_request(const uint8_t *data, uint32_t dataSize);
+void password_prefetch_on_ticker(void);
+bool password_prefetch_take(const uint8_t *data, uint32_t dataSize, uint8_t *seed);
+void password_prefetch_wipe(void);
+
+#endif
@@ -6,6 +6,8 @@
 
 #include "globals.h"
 #include "hid_mapping.h"
+#include "password_prefetch.h"
+#include "derivation_cache.h"
 
 static const uint8_t EMPTY_REPORT[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 static const uint8_t SPACE_REPORT[] = {0x00, 0x00, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x00};
@@ -14,7 +16,7 @@ static const uint8_t CAPS_LOCK_REPORT[] = {0x00, 0x00, 0x39, 0x00, 0x00, 0x00, 0
 static const uint8_t ENTER_REPORT[] = {0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00};
 
 uint8_t entropyProvided;
-uint8_t entropy[32];
+uint8_t entropy[PASSWORD_SEED_LEN];
 
 int entropyProvider2(void *context, unsigned char *buffer, size_t bufferSize) {
     if (entropyProvided) {
@@ -43,17 +45,10 @@ void io_usb_send_ep_wait(unsigned int ep,
     }
 }
 
-void type_password(uint8_t *data,
-                   uint32_t dataSize,
-                   uint8_t *out,
-                   setmask_t setMask,
-                   const uint8_t *minFromSet,
-                   uint32_t size) {
+void derive_password_seed(const uint8_t *data, uint32_t dataSize, uint8_t *seed) {
     uint32_t derive[9];
-    uint32_t led_status;
     uint8_t tmp[64];
     uint8_t i;
-    uint8_t report[8];
 
     cx_hash_sha256(data, dataSize, tmp, sizeof(tmp));
     derive[0] = DERIVE_PASSWORD_PATH;
@@ -63,12 +58,31 @@ void type_password(uint8_t *data,
     }
     os_perso_derive_node_bip32(CX_CURVE_SECP256K1, derive, 9, tmp, tmp + 32);
     // PRINTF("pwseed %.*H\n", 64, tmp);
-    cx_hash_sha256(tmp, 64, entropy, sizeof(entropy));
+    cx_hash_sha256(tmp, 64, seed, PASSWORD_SEED_LEN);
     os_memset(tmp, 0, sizeof(tmp));
+}
+
+void type_password(uint8_t *data,
+                   uint32_t dataSize,
+                   uint8_t *out,
+                   setmask_t setMask,
+                   const uint8_t *minFromSet,
+                   uint32_t size) {
+    uint8_t tmp[64];
+
+    // the selection flow may already have derived this seed while the user was reading, or
+    // the entry may have been used recently
+    if (!password_prefetch_take(data, dataSize, entropy) &&
+        !derivation_cache_get(data, dataSize, entropy)) {
+        derive_password_seed(data, dataSize, entropy);
+    }
+    derivation_cache_put(data, dataSize, entropy);
     entropyProvided = 0;
     mbedtls_ctr_drbg_context ctx;
     mbedtls_ctr_drbg_init(&ctx);
-    if (mbedtls_ctr_drbg_seed(&ctx, entropyProvider2, NULL, NULL, 0) != 0) {
+    int err = mbedtls_ctr_drbg_seed(&ctx, entropyProvider2, NULL, NULL, 0);
+    os_memset(entropy, 0, sizeof(entropy));
+    if (err != 0) {
         THROW(EXCEPTION);
     }
     if (out != NULL) {
@@ -77,6 +91,14 @@ void type_password(uint8_t *data,
     }
 
     generate_password(&ctx, setMask, minFromSet, tmp, size);
+    type_string(tmp, size, N_storage.press_enter_after_typing);
+    os_memset(tmp, 0, sizeof(tmp));
+}
+
+void type_string(const uint8_t *text, uint32_t size, bool press_enter) {
+    uint32_t led_status;
+    uint32_t i;
+    uint8_t report[8];
 
     os_memset(report, 0, sizeof(report));
     // Insert EMPTY_REPORT CAPS_REPORT EMPTY_REPORT to avoid undesired capital letter on KONSOLE
@@ -93,13 +115,13 @@ void type_password(uint8_t *data,
     }
     for (i = 0; i < size; i++) {
         // If keyboard layout not initialized, use the default
-        map_char(N_storage.keyboard_layout, tmp[i], report);
+        map_char(N_storage.keyboard_layout, text[i], report);
         io_usb_send_ep_wait(HID_EPIN_ADDR, report, 8, 20);
         io_usb_send_ep_wait(HID_EPIN_ADDR, (uint8_t *) EMPTY_REPORT, 8, 20);
 
         // for international keyboard, make sure to insert space after special symbols
         if (N_storage.keyboard_layout == HID_MAPPING_QWERTY_INTL) {
-            switch (tmp[i]) {
+            switch (text[i]) {
                 case '\"':
                 case '\'':
                 case '`':
@@ -118,7 +140,7 @@ void type_password(uint8_t *data,
         io_usb_send_ep_wait(HID_EPIN_ADDR, (uint8_t *) EMPTY_REPORT, 8, 20);
     }
 
-    if (N_storage.press_enter_after_typing) {
+    if (press_enter) {
         // press enter
         io_usb_send_ep_wait(HID_EPIN_ADDR, (uint8_t *) ENTER_REPORT, 8, 20);
         io_usb_send_ep_wait(HID_EPIN_ADDR, (uint8_t *) EMPTY_REPORT, 8, 20);
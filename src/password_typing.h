@@ -2,18 +2,25 @@
 #define __PASSWORD_TYPING_H__
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "password_generation.h"
 
 void io_usb_send_ep_wait(unsigned int ep,
                          unsigned char *buf,
                          unsigned int len,
                          unsigned int timeout_cs);
+#define PASSWORD_SEED_LEN 32
+
+/* Derives the 32 bytes seeding the password DRBG of the given entry */
+void derive_password_seed(const uint8_t *data, uint32_t dataSize, uint8_t *seed);
 void type_password(uint8_t *data,
                    uint32_t dataSize,
                    uint8_t *out,
                    setmask_t setMask,
                    const uint8_t *minFromSet,
                    uint32_t size);
+/* Types printable ASCII text (0x20 to 0x7E) with the configured keyboard layout */
+void type_string(const uint8_t *text, uint32_t size, bool press_enter);
 
 #define DERIVE_PASSWORD_PATH 0x80505744
 
@@ -8,24 +8,51 @@
 
 #include "globals.h"
 #include "password_typing.h"
+#include "password_prefetch.h"
+#include "derivation_cache.h"
+#include "entry_search.h"
+#include "entry_index.h"
+#include "entry_usage.h"
+#include "nickname_completion.h"
+#include "keyboard_order.h"
+#include "virtual_list.h"
 #include "metadata.h"
 #include "dispatcher.h"
 #include "sw.h"
 #include "io.h"
+#include "apdu_handlers/type_text.h"
 
 ux_state_t G_ux;
 bolos_ux_params_t G_ux_params;
 keyboard_ctx_t G_keyboard_ctx;
 
-const message_pair_t const ERR_MESSAGES[] = {
+const message_pair_t ERR_MESSAGES[] = {
     {"", ""},                             // OK
     {"Write Error", "Database is full"},  // ERR_NO_MORE_SPACE_AVAILABLE
     {"Write Error",
      "Database should be repaired, please contact Ledger Support"},  // ERR_CORRUPTED_METADATA
-    {"Erase Error", "Database already empty"}};                      // ERR_NO_METADATA
+    {"Erase Error", "Database already empty"},                       // ERR_NO_METADATA
+    {"Write Error", "Nickname too long"},                            // ERR_METADATA_ENTRY_TOO_BIG
+    {"Write Error", "Password already exists"}};                     // ERR_DUPLICATE_METADATA
+
+const char* const GROUP_NAMES[METADATA_GROUPS] =
+    {"No group", "Personal", "Work", "Finance", "Social", "Shopping", "Servers", "Other"};
 
 char line_buffer_1[16];
 char line_buffer_2[21];
+// wheels of the keyboard while typing a nickname, must outlive it
+keyboard_order_t nickname_keyboard_order;
+
+/* nickname keyboard: frequent characters first, and completion of the current word */
+void setup_nickname_keyboard() {
+    keyboard_order_compute(&nickname_keyboard_order);
+    screen_text_keyboard_set_class_order(KEYBOARD_CLASS_LOWERCASE,
+                                         nickname_keyboard_order.lowercase);
+    screen_text_keyboard_set_class_order(KEYBOARD_CLASS_UPPERCASE,
+                                         nickname_keyboard_order.uppercase);
+    screen_text_keyboard_set_class_order(KEYBOARD_CLASS_QUICK, nickname_keyboard_order.quick);
+    screen_text_keyboard_set_completion_callback(nickname_completion_find);
+}
 
 ///////////////////////////////// USER APPROVAL //////////////////////////////////////////////
 
@@ -57,123 +84,291 @@ void ui_request_user_approval(message_pair_t* msg) {
     ux_flow_init(0, request_user_approval_flow, NULL);
 }
 
-//////////////////////////////////// TYPE PASSWORD ///////////////////////////////////////////
-
-uint16_t current_entry_index;
-int8_t previous_location;  // max left: -1, middle: 0, max right: 1
-void (*selector_callback)();
-
-void display_next_entry(bool is_upper_border);
-void get_current_entry_name();
-void select_password_and_apply_cb();
-void type_password_cb(size_t offset);
-void show_password_cb(size_t offset);
-void reset_password_cb(size_t offset);
+/* the whole text to type, the approval covers every character of it */
+char approved_text[MAX_TYPED_TEXT_LEN + 1];
 
 // clang-format off
-UX_STEP_INIT(
-select_password_upper_border_step,
-NULL,
-NULL,
+UX_STEP_NOCB(
+review_text_step,
+bnnn_paging,
 {
-    display_next_entry(true);
+    "Type text",
+    approved_text,
 });
-UX_STEP_CB_INIT(
-select_password_current_entry_step,
-bn,
-get_current_entry_name(),
-select_password_and_apply_cb(),
+UX_STEP_NOCB(
+review_press_enter_step,
+nn,
 {
-    line_buffer_1,
-    line_buffer_2,
+    "then press",
+    "Enter",
 });
-UX_STEP_INIT(
-select_password_lower_border_step,
-NULL,
-NULL,
+UX_STEP_CB(
+approve_text_step,
+pb,
+app_state.user_approval = true; dispatch(),
 {
-    display_next_entry(false);
+    &C_icon_validate_14,
+    "Approve",
 });
 // clang-format on
 
-UX_FLOW(select_password_flow,
-        &select_password_upper_border_step,
-        &select_password_current_entry_step,
-        &select_password_lower_border_step);
+UX_FLOW(type_text_flow, &review_text_step, &approve_text_step, &generic_cancel_step);
+UX_FLOW(type_text_and_enter_flow,
+        &review_text_step,
+        &review_press_enter_step,
+        &approve_text_step,
+        &generic_cancel_step);
 
-void display_type_password_flow() {
-    current_entry_index = 0;
-    previous_location = -1;
-    selector_callback = type_password_cb;
-    ux_flow_init(0, select_password_flow, NULL);
+void ui_request_text_approval(const uint8_t* text, size_t len, bool press_enter) {
+    len = len < sizeof(approved_text) ? len : sizeof(approved_text) - 1;
+    os_memcpy(approved_text, text, len);
+    approved_text[len] = '\0';
+    ux_flow_init(0, press_enter ? type_text_and_enter_flow : type_text_flow, NULL);
 }
 
-void display_show_password_flow() {
-    current_entry_index = 0;
-    previous_location = -1;
-    selector_callback = show_password_cb;
-    ux_flow_init(0, select_password_flow, NULL);
+//////////////////////////////////// TYPE PASSWORD ///////////////////////////////////////////
+
+/* entries marked in the delete list, erased together */
+#define MAX_MARKED_ENTRIES 32
+#define ALL_GROUPS         0xFF
+
+void (*selector_callback)();
+bool search_results_only;  // only list the entries matching the last search
+uint8_t list_group;        // only list the entries of this group, unless ALL_GROUPS
+uint16_t marked_offsets[MAX_MARKED_ENTRIES];
+uint8_t marked_count;
+uint16_t marks_generation;         // changed by every mark, as the labels depend on the marks
+uint16_t marked_index_generation;  // entry index generation the offsets were marked for
+bool marks_dropped;                // the entries moved, the user is not told yet
+
+void type_password_cb(size_t offset);
+void show_password_cb(size_t offset);
+void reset_password_cb(size_t offset);
+void toggle_favourite_cb(size_t offset);
+void assign_group_cb(size_t offset);
+void enter_jump_letter();
+void display_groups_flow();
+
+uint16_t get_entries_count() {
+    if (search_results_only) {
+        return entry_search_count();
+    }
+    if (list_group != ALL_GROUPS) {
+        return entry_index_group_count(list_group);
+    }
+    return entry_index_available() ? entry_index_count() : N_storage.metadata_count;
 }
 
-void display_reset_password_flow() {
-    current_entry_index = 0;
-    previous_location = -1;
-    selector_callback = reset_password_cb;
-    ux_flow_init(0, select_password_flow, NULL);
-}
-
-void display_next_entry(bool is_upper_border) {
-    if (is_upper_border) {
-        if (previous_location != -1) {
-            if (current_entry_index > 0) {
-                current_entry_index--;
-            } else {
-                current_entry_index = N_storage.metadata_count;  // Loop back
-            }
+/* search results and groups are listed in their own order, with ORDER_CREATION */
+list_order_e get_list_order() {
+    if (search_results_only || list_group != ALL_GROUPS || !entry_index_available() ||
+        get_entries_count() == 0) {
+        return ORDER_CREATION;
+    }
+    // the favourites and groups are picked in a list which does not reorder itself at each
+    // choice, assigning a group may move the entry to the end of the log
+    if ((N_storage.list_order == ORDER_RECENT && selector_callback == toggle_favourite_cb) ||
+        selector_callback == assign_group_cb) {
+        return ORDER_ALPHABETICAL;
+    }
+    return N_storage.list_order;
+}
+
+bool is_sorted_view() {
+    return get_list_order() == ORDER_ALPHABETICAL;
+}
+
+bool is_deleting_marked() {
+    return selector_callback == reset_password_cb && marked_count > 0;
+}
+
+/* index of the "Cancel" item closing the list, preceded by "Jump to letter" when sorted and
+ * by "Delete marked" once entries are marked for deletion */
+uint16_t get_last_item_index() {
+    return get_entries_count() + (is_sorted_view() ? 1 : 0) + (is_deleting_marked() ? 1 : 0);
+}
+
+bool is_jump_item(uint16_t index) {
+    return is_sorted_view() && index == get_entries_count();
+}
+
+bool is_delete_item(uint16_t index) {
+    return is_deleting_marked() && index == get_last_item_index() - 1;
+}
+
+void clear_marks() {
+    marked_count = 0;
+    marks_generation++;
+    marked_index_generation = entry_index_generation();
+    marks_dropped = false;
+}
+
+bool ui_has_marked_entries(void) {
+    return is_deleting_marked();
+}
+
+int8_t find_mark(size_t offset) {
+    for (uint8_t i = 0; i < marked_count; i++) {
+        if (marked_offsets[i] == offset) {
+            return i;
         }
-        ux_flow_next();
     }
-    if (!is_upper_border) {
-        if (current_entry_index < N_storage.metadata_count) {
-            current_entry_index++;
+    return -1;
+}
+
+/* the labels depend on the entries, and on the marks of the delete list */
+uint16_t get_list_generation() {
+    if (marked_count > 0 && marked_index_generation != entry_index_generation()) {
+        // entries moved since they were marked
+        clear_marks();
+        marks_dropped = true;
+    }
+    return entry_index_generation() + marks_generation;
+}
+
+/* offset of the entry listed at index, METADATA_END for the items following the entries */
+size_t get_entry_offset(uint16_t index) {
+    if (search_results_only) {
+        int32_t nth = entry_search_nth(index);
+        return nth < 0 ? METADATA_END : get_metadata(nth);
+    }
+    if (list_group != ALL_GROUPS) {
+        return entry_index_group_offset(list_group, index);
+    }
+    switch (get_list_order()) {
+        case ORDER_ALPHABETICAL:
+            return entry_index_sorted_offset(index);
+        case ORDER_RECENT:
+            return entry_index_recent_offset(index);
+        default:
+            return get_metadata(index);
+    }
+}
+
+uint16_t get_items_count() {
+    return get_last_item_index() + 1;
+}
+
+size_t render_entry_item(uint16_t index, char* line_1, char* line_2) {
+    size_t offset = get_entry_offset(index);
+    if (is_jump_item(index)) {
+        strcpy(line_1, "");
+        strcpy(line_2, "Jump to letter");
+    } else if (is_delete_item(index)) {
+        strcpy(line_1, "Delete marked");
+        snprintf(line_2, VIRTUAL_LIST_LINE_2_SIZE, "%d passwords", marked_count);
+    } else if (offset == METADATA_END) {
+        strcpy(line_1, "");
+        strcpy(line_2, "Cancel");
+    } else {
+        if (selector_callback == toggle_favourite_cb) {
+            strcpy(line_1, entry_usage_is_favourite(offset) ? "Favourite" : "Not favourite");
+        } else if (selector_callback == assign_group_cb) {
+            strcpy(line_1, (const char*) PIC(GROUP_NAMES[METADATA_GROUP(offset)]));
+        } else if (selector_callback == reset_password_cb && find_mark(offset) >= 0) {
+            snprintf(line_1,
+                     VIRTUAL_LIST_LINE_1_SIZE,
+                     "Marked %d/%d",
+                     index + 1,
+                     get_entries_count());
         } else {
-            current_entry_index = 0;
+            snprintf(line_1,
+                     VIRTUAL_LIST_LINE_1_SIZE,
+                     search_results_only ? "Match %d/%d" : "Password %d/%d",
+                     index + 1,
+                     get_entries_count());
         }
-        ux_flow_prev();
+        get_metadata_nickname(offset, line_2);
     }
+    return offset;
 }
 
-void get_current_entry_name() {
-    size_t offset = get_metadata(current_entry_index);
-    if (offset == -1UL) {
-        strcpy(line_buffer_1, "");
-        strcpy(line_buffer_2, "Cancel");
-        previous_location = 1;
-    } else {
-        SPRINTF(line_buffer_1, "Password %d/%d", current_entry_index + 1, N_storage.metadata_count);
-        memcpy(line_buffer_2, (void*) METADATA_NICKNAME(offset), METADATA_NICKNAME_LEN(offset));
-        line_buffer_2[METADATA_NICKNAME_LEN(offset)] = '\0';
-        previous_location = 0;
+void focus_entry_item(uint16_t index, size_t offset) {
+    UNUSED(index);
+    if (offset == METADATA_END) {
+        password_prefetch_wipe();
+    } else if (selector_callback == type_password_cb || selector_callback == show_password_cb) {
+        // get the password ready while the user decides
+        char nickname[MAX_METANAME + 1];
+        uint8_t nickname_len = get_metadata_nickname(offset, nickname);
+        password_prefetch_request((const uint8_t*) nickname, nickname_len);
     }
 }
 
-void select_password_and_apply_cb() {
-    size_t offset = get_metadata(current_entry_index);
-    // Check if user didn't click on "cancel"
-    if (offset != -1UL) {
+void delete_marked_entries();
+
+void select_entry_item(uint16_t index, size_t offset) {
+    if (is_jump_item(index)) {
+        enter_jump_letter();
+    } else if (is_delete_item(index)) {
+        delete_marked_entries();
+    } else if (offset != METADATA_END) {  // Check if user didn't click on "cancel"
         selector_callback(offset);
+    } else if (list_group != ALL_GROUPS) {
+        display_groups_flow();
     } else {
         ui_idle();
     }
 }
 
+/* one page per initial letter */
+uint16_t get_initial_page(uint16_t index, bool forward) {
+    return forward ? entry_index_next_initial(index) : entry_index_previous_initial(index);
+}
+
+const virtual_list_source_t entries_list = {
+    .count = get_items_count,
+    .render = render_entry_item,
+    .focus = focus_entry_item,
+    .select = select_entry_item,
+    .page = NULL,
+    .generation = get_list_generation,
+};
+
+const virtual_list_source_t sorted_entries_list = {
+    .count = get_items_count,
+    .render = render_entry_item,
+    .focus = focus_entry_item,
+    .select = select_entry_item,
+    .page = get_initial_page,
+    .generation = get_list_generation,
+};
+
+void display_entries_list(void (*callback)(size_t),
+                          bool search_results,
+                          uint8_t group,
+                          uint16_t current) {
+    selector_callback = callback;
+    search_results_only = search_results;
+    list_group = group;
+    virtual_list_display(is_sorted_view() ? &sorted_entries_list : &entries_list, current);
+}
+
+void display_type_password_flow() {
+    display_entries_list(type_password_cb, false, ALL_GROUPS, 0);
+}
+
+void display_show_password_flow() {
+    display_entries_list(show_password_cb, false, ALL_GROUPS, 0);
+}
+
+void display_reset_password_flow() {
+    // pending usage data could move legacy records while entries are being marked
+    entry_usage_flush();
+    clear_marks();
+    display_entries_list(reset_password_cb, false, ALL_GROUPS, 0);
+}
+
 void type_password_cb(size_t offset) {
     unsigned char enabledSets = METADATA_SETS(offset);
     if (enabledSets == 0) {
         enabledSets = ALL_SETS;
     }
-    type_password((uint8_t*) METADATA_NICKNAME(offset),
-                  METADATA_NICKNAME_LEN(offset),
+    entry_usage_record(offset);
+    char nickname[MAX_METANAME + 1];
+    uint8_t nickname_len = get_metadata_nickname(offset, nickname);
+    type_password((uint8_t*) nickname,
+                  nickname_len,
                   NULL,
                   enabledSets,
                   (const uint8_t*) PIC(DEFAULT_MIN_SET),
@@ -181,8 +376,70 @@ void type_password_cb(size_t offset) {
     ui_idle();
 }
 
+// clang-format off
+UX_STEP_CB(
+too_many_marks_step,
+nn,
+virtual_list_redisplay(),
+{
+    "Can't mark more,",
+    line_buffer_2,
+});
+UX_STEP_CB(
+marks_dropped_step,
+nn,
+virtual_list_redisplay(),
+{
+    "Entries moved,",
+    "marks cleared",
+});
+// clang-format on
+
+UX_FLOW(too_many_marks_flow, &too_many_marks_step);
+UX_FLOW(marks_dropped_flow, &marks_dropped_step);
+
+/* tells the user that the marks were dropped, then goes back to the list, returns whether they
+ * were */
+static bool show_marks_dropped() {
+    if (!marks_dropped) {
+        return false;
+    }
+    marks_dropped = false;
+    ux_flow_init(0, marks_dropped_flow, NULL);
+    return true;
+}
+
+void ui_on_ticker(void) {
+    if (virtual_list_is_displayed()) {
+        get_list_generation();  // drops the marks if entries moved while the list is shown
+        show_marks_dropped();
+    }
+}
+
+/* marks or unmarks the entry, the marked ones are deleted from the "Delete marked" item */
 void reset_password_cb(size_t offset) {
-    error_type_t err = erase_metadata(offset);
+    int8_t mark = find_mark(offset);
+    if (mark >= 0) {
+        marked_offsets[mark] = marked_offsets[--marked_count];
+    } else if (marked_count < MAX_MARKED_ENTRIES) {
+        marked_offsets[marked_count++] = offset;
+    } else {
+        // back to the same entry once acknowledged
+        snprintf(line_buffer_2, sizeof(line_buffer_2), "%d entries max", MAX_MARKED_ENTRIES);
+        ux_flow_init(0, too_many_marks_flow, NULL);
+        return;
+    }
+    marks_generation++;
+    virtual_list_redisplay();
+}
+
+void delete_marked_entries() {
+    get_list_generation();  // drops the marks if entries moved in the meantime
+    if (show_marks_dropped()) {
+        return;
+    }
+    error_type_t err = erase_metadatas(marked_offsets, marked_count);
+    clear_marks();
     if (err != OK) {
         ui_error(ERR_MESSAGES[err]);
         return;
@@ -190,6 +447,141 @@ void reset_password_cb(size_t offset) {
     ui_idle();
 }
 
+void display_favourites_flow() {
+    display_entries_list(toggle_favourite_cb, false, ALL_GROUPS, 0);
+}
+
+void toggle_favourite_cb(size_t offset) {
+    entry_usage_toggle_favourite(offset);
+    virtual_list_redisplay();  // stay on the same entry
+}
+
+//////////////////////////////// GROUPS ////////////////////////////////////////////////////////
+
+/* the groups having entries, then "Cancel" */
+uint16_t get_groups_count() {
+    uint16_t count = 1;
+    for (uint8_t group = 0; group < METADATA_GROUPS; group++) {
+        if (entry_index_group_count(group) != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* group listed at index, METADATA_GROUPS for "Cancel" */
+uint8_t get_listed_group(uint16_t index) {
+    for (uint8_t group = 0; group < METADATA_GROUPS; group++) {
+        if (entry_index_group_count(group) != 0 && index-- == 0) {
+            return group;
+        }
+    }
+    return METADATA_GROUPS;
+}
+
+size_t render_group_item(uint16_t index, char* line_1, char* line_2) {
+    uint8_t group = get_listed_group(index);
+    if (group == METADATA_GROUPS) {
+        strcpy(line_1, "");
+        strcpy(line_2, "Cancel");
+    } else {
+        snprintf(line_1, VIRTUAL_LIST_LINE_1_SIZE, "%d passwords", entry_index_group_count(group));
+        strcpy(line_2, (const char*) PIC(GROUP_NAMES[group]));
+    }
+    return group;
+}
+
+void select_group_item(uint16_t index, size_t group) {
+    UNUSED(index);
+    if (group == METADATA_GROUPS) {
+        ui_idle();
+    } else {
+        display_entries_list(type_password_cb, false, group, 0);
+    }
+}
+
+const virtual_list_source_t groups_list = {
+    .count = get_groups_count,
+    .render = render_group_item,
+    .focus = NULL,
+    .select = select_group_item,
+    .page = NULL,
+    .generation = entry_index_generation,
+};
+
+void display_groups_flow() {
+    if (!entry_index_available()) {
+        message_pair_t msg = {"Too many", "passwords to group"};
+        ui_error(msg);
+        return;
+    }
+    virtual_list_display(&groups_list, 0);
+}
+
+void display_assign_groups_flow() {
+    display_entries_list(assign_group_cb, false, ALL_GROUPS, 0);
+}
+
+/* moves the entry to the next group */
+void assign_group_cb(size_t offset) {
+    error_type_t err = set_metadata_group(offset, (METADATA_GROUP(offset) + 1) % METADATA_GROUPS);
+    if (err != OK) {
+        ui_error(ERR_MESSAGES[err]);
+        return;
+    }
+    virtual_list_redisplay();  // stay on the same entry
+}
+
+//////////////////////////////// JUMP TO LETTER ////////////////////////////////////////////////
+
+void jump_to_letter() {
+    // the first entry whose nickname starts with the letter, or the closest one after it
+    uint16_t index = entry_index_lower_bound(G_keyboard_ctx.words_buffer[0]);
+    if (index >= get_entries_count() && index > 0) {
+        index--;
+    }
+    virtual_list_display(&sorted_entries_list, index);
+}
+
+void enter_jump_letter() {
+#if defined(TARGET_NANOX) || defined(TARGET_NANOS2)
+    strcpy(G_keyboard_ctx.title, "Jump to letter");
+#endif
+    os_memset(G_keyboard_ctx.words_buffer, 0, sizeof(G_keyboard_ctx.words_buffer));
+    screen_text_keyboard_init(G_keyboard_ctx.words_buffer, 1, jump_to_letter);
+}
+
+//////////////////////////////// SEARCH PASSWORD ///////////////////////////////////////////////
+
+void update_search_results() {
+    entry_search_update(G_keyboard_ctx.words_buffer);
+#if defined(TARGET_NANOX) || defined(TARGET_NANOS2)
+    SPRINTF(G_keyboard_ctx.title, "%d matches", entry_search_count());
+#endif
+}
+
+void display_search_results_flow() {
+    if (entry_search_count() == 0) {
+        message_pair_t msg = {"No match for", G_keyboard_ctx.words_buffer};
+        ui_error(msg);
+        return;
+    }
+    display_entries_list(type_password_cb, true, ALL_GROUPS, 0);
+}
+
+void enter_search_query() {
+#if defined(TARGET_NANOX) || defined(TARGET_NANOS2)
+    strcpy(G_keyboard_ctx.title, "Search");
+#endif
+    os_memset(G_keyboard_ctx.words_buffer, 0, sizeof(G_keyboard_ctx.words_buffer));
+    entry_search_reset();
+    screen_text_keyboard_init(G_keyboard_ctx.words_buffer,
+                              MAX_METANAME,
+                              display_search_results_flow);
+    screen_text_keyboard_set_change_callback(update_search_results);
+    setup_nickname_keyboard();
+}
+
 //////////////////////////////// SHOW PASSWORD ///////////////////////////////////////////////
 
 // clang-format off
@@ -207,14 +599,16 @@ UX_FLOW(show_password_flow,
 // clang-format on
 
 void show_password_cb(size_t offset) {
-    memcpy(line_buffer_1, (void*) METADATA_NICKNAME(offset), METADATA_NICKNAME_LEN(offset));
-    line_buffer_1[METADATA_NICKNAME_LEN(offset)] = '\0';
+    char nickname[MAX_METANAME + 1];
+    uint8_t nickname_len = get_metadata_nickname(offset, nickname);
+    snprintf(line_buffer_1, sizeof(line_buffer_1), "%s", nickname);
     unsigned char enabledSets = METADATA_SETS(offset);
     if (enabledSets == 0) {
         enabledSets = ALL_SETS;
     }
-    type_password((uint8_t*) METADATA_NICKNAME(offset),
-                  METADATA_NICKNAME_LEN(offset),
+    entry_usage_record(offset);
+    type_password((uint8_t*) nickname,
+                  nickname_len,
                   (uint8_t*) line_buffer_2,
                   enabledSets,
                   (const uint8_t*) PIC(DEFAULT_MIN_SET),
@@ -345,6 +739,7 @@ void enter_password_nickname() {
 #endif
     os_memset(G_keyboard_ctx.words_buffer, 0, sizeof(G_keyboard_ctx.words_buffer));
     screen_text_keyboard_init(G_keyboard_ctx.words_buffer, MAX_METANAME, create_password_entry);
+    setup_nickname_keyboard();
 }
 
 // clang-format off
@@ -382,12 +777,41 @@ void ui_error(message_pair_t err) {
     ux_flow_init(0, err_corrupted_memory_flow, NULL);
 }
 
+// clang-format off
+UX_STEP_NOCB(
+entries_dropped_step,
+bnnn_paging,
+{
+    "Storage repaired",
+    line_buffer_2,
+});
+UX_STEP_CB(
+entries_dropped_continue_step,
+pb,
+ui_idle(),
+{
+    &C_icon_validate_14,
+    "Continue",
+});
+// clang-format on
+
+UX_FLOW(entries_dropped_flow, &entries_dropped_step, &entries_dropped_continue_step);
+
+void ui_entries_dropped(uint16_t count) {
+    snprintf(line_buffer_2, sizeof(line_buffer_2), "%u entries lost", (unsigned int) count);
+    ux_flow_init(0, entries_dropped_flow, NULL);
+}
+
 /////////////////////////////////// SETTINGS ////////////////////////////////////////////
 
 void display_change_keyboard_flow(const ux_flow_step_t* const start_step);
 void display_reset_password_list_flow();
 void get_current_pressEnterAfterTyping_setting_value();
 void switch_setting_pressEnterAfterTyping();
+void get_current_cacheRecentPasswords_setting_value();
+void switch_setting_cacheRecentPasswords();
+void get_current_listOrder_setting_value();
+void switch_setting_listOrder();
 
 // clang-format off
 UX_STEP_CB(
@@ -415,12 +839,50 @@ switch_setting_pressEnterAfterTyping(),
     line_buffer_2,
     "after typing",
 });
+UX_STEP_CB_INIT(
+settings_cacheRecentPasswords_step,
+nn,
+get_current_cacheRecentPasswords_setting_value(),
+switch_setting_cacheRecentPasswords(),
+{
+    line_buffer_2,
+    "recent passwords",
+});
+UX_STEP_CB_INIT(
+settings_listOrder_step,
+nn,
+get_current_listOrder_setting_value(),
+switch_setting_listOrder(),
+{
+    line_buffer_2,
+    "order",
+});
+UX_STEP_CB(
+settings_favourites_step,
+nn,
+display_favourites_flow(),
+{
+    "Choose favourite",
+    "passwords",
+});
+UX_STEP_CB(
+settings_groups_step,
+nn,
+display_assign_groups_flow(),
+{
+    "Assign password",
+    "groups",
+});
 // clang-format on
 
 UX_FLOW(settings_flow,
         &settings_change_keyboard_step,
         &settings_reset_password_list_step,
         &settings_pressEnterAfterTyping_step,
+        &settings_cacheRecentPasswords_step,
+        &settings_listOrder_step,
+        &settings_favourites_step,
+        &settings_groups_step,
         &generic_cancel_step,
         FLOW_LOOP);
 
@@ -445,6 +907,41 @@ void switch_setting_pressEnterAfterTyping() {
     display_settings_flow(&settings_pressEnterAfterTyping_step);
 }
 
+void get_current_cacheRecentPasswords_setting_value() {
+    if (N_storage.cache_recent_passwords) {
+        strcpy(line_buffer_2, "Cache");
+    } else {
+        strcpy(line_buffer_2, "Don't cache");
+    }
+}
+
+void switch_setting_cacheRecentPasswords() {
+    bool new_value = !N_storage.cache_recent_passwords;
+    nvm_write((void*) &N_storage.cache_recent_passwords, (void*) &new_value, sizeof(new_value));
+    derivation_cache_wipe();
+    display_settings_flow(&settings_cacheRecentPasswords_step);
+}
+
+void get_current_listOrder_setting_value() {
+    switch (N_storage.list_order) {
+        case ORDER_ALPHABETICAL:
+            strcpy(line_buffer_2, "Alphabetical");
+            break;
+        case ORDER_RECENT:
+            strcpy(line_buffer_2, "Recently used");
+            break;
+        default:
+            strcpy(line_buffer_2, "Creation");
+            break;
+    }
+}
+
+void switch_setting_listOrder() {
+    uint8_t new_value = (N_storage.list_order + 1) % (ORDER_RECENT + 1);
+    nvm_write((void*) &N_storage.list_order, (void*) &new_value, sizeof(new_value));
+    display_settings_flow(&settings_listOrder_step);
+}
+
 ////////////////////////// SETTINGS - CHANGE KEYBOARD LAYOUT //////////////////////////////////////
 
 bagl_icon_details_t is_selected_icon;
@@ -555,6 +1052,22 @@ display_type_password_flow(),
     "Type password", 
 });
 UX_STEP_CB(
+idle_search_password_step,
+pb,
+enter_search_query(),
+{
+    &C_icon_search,
+    "Search password",
+});
+UX_STEP_CB(
+idle_groups_step,
+pb,
+display_groups_flow(),
+{
+    &C_icon_folder,
+    "Browse groups",
+});
+UX_STEP_CB(
 idle_show_password_step,
 pb,
 display_show_password_flow(),
@@ -596,7 +1109,7 @@ bn,
 UX_STEP_CB(
 idle_quit_step,
 pb,
-os_sched_exit(-1),
+app_save_before_exit(); os_sched_exit(-1),
 {
     &C_icon_dashboard,
     "Quit",
@@ -605,6 +1118,8 @@ os_sched_exit(-1),
 
 UX_FLOW(idle_flow,
         &idle_type_password_step,
+        &idle_search_password_step,
+        &idle_groups_step,
         &idle_show_password_step,
         &idle_new_password_step,
         &idle_reset_password_step,
@@ -631,6 +1146,9 @@ UX_FLOW(setup_keyboard_at_init_flow,
         &azerty_step);
 
 void ui_idle() {
+    password_prefetch_wipe();
+    // the delete list is left, with its marks
+    clear_marks();
     if (G_ux.stack_count == 0) {
         ux_stack_push();
     }
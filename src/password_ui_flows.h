@@ -4,11 +4,19 @@
 #include "ux.h"
 #include "types.h"
 
-extern const message_pair_t const ERR_MESSAGES[];
+extern const message_pair_t ERR_MESSAGES[];
 
 void ui_idle();
 void ui_request_user_approval(message_pair_t *msg);
+/* shows the whole text, and whether Enter is pressed after it, before it is typed */
+void ui_request_text_approval(const uint8_t *text, size_t len, bool press_enter);
 void ui_error(message_pair_t err);
+/* tells the user that entries were lost, then shows the main menu */
+void ui_entries_dropped(uint16_t count);
+/* entries are marked for deletion in the delete list */
+bool ui_has_marked_entries(void);
+/* tells the user when the marks of the delete list were dropped, as the entries moved */
+void ui_on_ticker(void);
 
 #define UPPERCASE_BITFLAG   1
 #define LOWERCASE_BITFLAG   2
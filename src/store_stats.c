@@ -0,0 +1,55 @@
+#include "store_stats.h"
+
+#include "os.h"
+
+#include "globals.h"
+#include "metadata.h"
+
+/* counted since the last flush */
+static store_counters_t pending;
+static uint16_t ticks;
+
+void store_write(void *destination, void *source, uint32_t len) {
+    nvm_write(destination, source, len);
+    pending.bytes_written += len;
+}
+
+void store_stats_on_compaction(void) {
+    pending.compactions++;
+}
+
+void store_stats_get(store_stats_t *stats) {
+    uint32_t erased_bytes = 0;
+    for (uint32_t offset = metadata_first(); offset != METADATA_END;
+         offset = metadata_next(offset)) {
+        if (METADATA_KIND(offset) == META_ERASED) {
+            erased_bytes += METADATA_TOTAL_LEN(offset);
+        }
+    }
+    stats->entries = N_storage.metadata_count;
+    stats->erased_bytes = erased_bytes;
+    stats->free_bytes = MAX_METADATAS - find_free_metadata();
+    stats->fragmentation = erased_bytes != 0
+                               ? erased_bytes * 1000 / (erased_bytes + stats->free_bytes)
+                               : 0;
+    stats->compactions = N_storage.store_counters.compactions + pending.compactions;
+    stats->bytes_written = N_storage.store_counters.bytes_written + pending.bytes_written;
+}
+
+void store_stats_flush(void) {
+    if (pending.compactions == 0 && pending.bytes_written == 0) {
+        return;
+    }
+    store_counters_t counters;
+    counters.compactions = N_storage.store_counters.compactions + pending.compactions;
+    counters.bytes_written = N_storage.store_counters.bytes_written + pending.bytes_written;
+    nvm_write((void *) &N_storage.store_counters, &counters, sizeof(counters));
+    os_memset(&pending, 0, sizeof(pending));
+}
+
+void store_stats_on_ticker(void) {
+    if (++ticks >= STORE_STATS_FLUSH_TICKS) {
+        ticks = 0;
+        store_stats_flush();
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef __STORE_STATS_H__
+#define __STORE_STATS_H__
+
+#include "stdint.h"
+
+/* ticker events (100ms) between two writes of the counters, when they changed */
+#define STORE_STATS_FLUSH_TICKS 600
+
+/* state of the store and of its flash, as reported by GET_STORE_STATS */
+typedef struct store_stats_s {
+    uint16_t entries;
+    uint32_t erased_bytes;   // taken by erased records until the next compaction
+    uint32_t free_bytes;     // after the last record, the only free run of the log
+    uint16_t fragmentation;  // per mille of the reclaimable space taken by erased records
+    uint32_t compactions;
+    uint32_t bytes_written;
+} store_stats_t;
+
+/*
+ * Flash use of the store since it was created: the writes and compactions are counted in RAM,
+ * and added to N_storage.store_counters every STORE_STATS_FLUSH_TICKS and when leaving the
+ * app, so that counting them costs no write of its own. store_write() is the nvm_write() of
+ * the store, counting the bytes written.
+ */
+void store_write(void *destination, void *source, uint32_t len);
+void store_stats_on_compaction(void);
+void store_stats_get(store_stats_t *stats);
+void store_stats_flush(void);
+void store_stats_on_ticker(void);
+
+#endif
@@ -5,6 +5,8 @@
 #define SW_CONDITIONS_OF_USE_NOT_SATISFIED 0x6985
 #define SW_WRONG_P1P2                      0x6A86
 #define SW_WRONG_DATA_LENGTH               0x6A87
+#define SW_WRONG_DATA                      0x6A80
+#define SW_ENTRY_NOT_FOUND                 0x6A88
 #define SW_INS_NOT_SUPPORTED               0x6D00
 #define SW_CLA_NOT_SUPPORTED               0x6E00
 #define SW_APPNAME_TOO_LONG                0xB000
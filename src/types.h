@@ -5,25 +5,86 @@
 #include <stdint.h>
 #include "stdbool.h"
 
+/* compaction writes the records one flash page at a time, so that each page it moves records
+ * to is programmed once; this is the page size of the Nano S */
+#ifndef METADATA_PAGE_SIZE
+#define METADATA_PAGE_SIZE 64
+#endif
+
+/**
+ * A compaction step: the page of records about to be written and where the compaction goes on
+ * after it. Each step is written to the journal before its page is written, so a compaction
+ * interrupted by a reset is completed from the last step whose checksum is valid.
+ */
+typedef struct compaction_step_s {
+    uint32_t sequence;     // 0 for no step, the last step has the highest sequence
+    uint16_t destination;  // offset of page[0] in the store
+    uint16_t source;       // next byte to move after the page
+    uint16_t next_record;  // end of the record source is in
+    uint16_t end;          // end of the log before the compaction
+    uint8_t len;           // bytes of page to write
+    bool last;             // the page ends with the free space marker
+    uint8_t page[METADATA_PAGE_SIZE];
+    uint16_t checksum;  // Fletcher-16 of the fields above, detects a torn write
+} compaction_step_t;
+
+/**
+ * Progress of a migration of the records to a newer format: they are converted from the active
+ * bank to the other one, which only becomes active once they all are. It is written each time
+ * a batch of converted records is, so an interrupted migration goes on from the last batch.
+ */
+typedef struct migration_progress_s {
+    uint8_t version;       // format the records are converted to, 0 when none is running
+    uint16_t source;       // next record to convert, in the active bank
+    uint16_t destination;  // where it goes in the other bank
+    uint16_t count;        // entries converted so far
+    uint32_t digest;       // their digest
+    uint16_t checksum;     // Fletcher-16 of the fields above, detects a torn write
+} migration_progress_t;
+
+/**
+ * Counters of the store since it was created, kept in RAM and written from time to time: the
+ * updates of the last minute can be lost with a reset.
+ */
+typedef struct store_counters_s {
+    uint32_t compactions;    // passes which reclaimed erased records
+    uint32_t bytes_written;  // by the store, to its records and its header
+} store_counters_t;
+
 typedef struct internalStorage_t {
-#define STORAGE_MAGIC 0xDEAD1337
+/* changed with the layout below: the storage of an older release is initialized again, never
+ * read through this struct */
+#define STORAGE_MAGIC 0xDEAD1338
     uint32_t magic;
     bool press_enter_after_typing;
     uint32_t keyboard_layout;
+    bool cache_recent_passwords;
+    uint8_t list_order;
     /**
      * A metadata in memory is represented by 1 byte of size (l), 1 byte of type (to disable it if
      * required), 1 byte to select char sets, l bytes of user seed
      */
+    uint8_t active_bank;  // bank holding the records, loads are written to the other one
+    uint8_t metadata_version;  // format of the records, see METADATA_VERSION
     size_t metadata_count;
-    uint8_t metadatas[MAX_METADATAS];
+    uint32_t metadata_digest;  // sum of the checksums of the entries, written with the count
+    uint8_t metadata_banks[2][MAX_METADATAS];
+    compaction_step_t journal[2];  // steps are written alternately in each slot
+    migration_progress_t migration;
+    store_counters_t store_counters;
 } internalStorage_t;
 
 typedef enum { READY, RECEIVED, WAITING } io_state_e;
 
+typedef enum { ORDER_CREATION = 0, ORDER_ALPHABETICAL, ORDER_RECENT } list_order_e;
+
 typedef enum {
     GET_APP_CONFIG = 0x03,
     DUMP_METADATAS = 0x04,
     LOAD_METADATAS = 0x05,
+    TYPE_TEXT = 0x06,
+    GET_PASSWORD = 0x07,
+    GET_STORE_STATS = 0x08,
 #ifdef TESTING
     RUN_TEST = 0x99
 #endif
@@ -37,6 +98,8 @@ typedef struct app_state_s {
     cmd_e current_command;
     size_t bytes_transferred;
     bool user_approval;
+    uint32_t approved_offset;                  // entry shown by the pending GET_PASSWORD approval
+    char approved_nickname[MAX_METANAME + 1];  // and its nickname
 } app_state_t;
 
 typedef struct {
@@ -0,0 +1,258 @@
+#include "virtual_list.h"
+
+#include "os.h"
+#include "ux.h"
+#include "string.h"
+
+/* held button repeat events scrolling one item at a time, before scrolling by pages */
+#define SCROLL_PAGE_AFTER_REPEATS 10
+#define SCROLL_PAGE_SIZE          10
+
+typedef struct list_label_s {
+    bool valid;
+    uint16_t index;
+    size_t value;
+    char line_1[VIRTUAL_LIST_LINE_1_SIZE];
+    char line_2[VIRTUAL_LIST_LINE_2_SIZE];
+} list_label_t;
+
+typedef struct virtual_list_s {
+    virtual_list_source_t source;  // callbacks already relocated
+    uint16_t current;
+    bool entering;            // the border step the flow starts on must not move
+    uint16_t scroll_repeats;  // repeat events received since the button is held
+    uint16_t generation;      // of the source, when the labels were rendered
+    list_label_t labels[VIRTUAL_LIST_CACHE_SIZE];
+} virtual_list_t;
+
+static virtual_list_t virtual_list;
+
+char virtual_list_line_1[VIRTUAL_LIST_LINE_1_SIZE];
+char virtual_list_line_2[VIRTUAL_LIST_LINE_2_SIZE];
+
+static void display_next_item(bool is_upper_border);
+static void display_current_item(void);
+static void select_current_item(void);
+
+// clang-format off
+UX_STEP_INIT(
+virtual_list_upper_border_step,
+NULL,
+NULL,
+{
+    display_next_item(true);
+});
+UX_STEP_CB_INIT(
+virtual_list_current_step,
+bn,
+display_current_item(),
+select_current_item(),
+{
+    virtual_list_line_1,
+    virtual_list_line_2,
+});
+UX_STEP_INIT(
+virtual_list_lower_border_step,
+NULL,
+NULL,
+{
+    display_next_item(false);
+});
+// clang-format on
+
+UX_FLOW(virtual_list_flow,
+        &virtual_list_upper_border_step,
+        &virtual_list_current_step,
+        &virtual_list_lower_border_step);
+
+static uint16_t get_generation(void) {
+    return virtual_list.source.generation != NULL ? virtual_list.source.generation() : 0;
+}
+
+static uint16_t get_last_index(void) {
+    uint16_t count = virtual_list.source.count();
+    return count > 0 ? count - 1 : 0;
+}
+
+static void reset_labels(void) {
+    memset(virtual_list.labels, 0, sizeof(virtual_list.labels));
+    virtual_list.generation = get_generation();
+}
+
+/* circular distance between an item of the list and the current one */
+static uint16_t get_distance_to_current(uint16_t index) {
+    uint16_t distance = index > virtual_list.current ? index - virtual_list.current
+                                                     : virtual_list.current - index;
+    uint16_t wrapped = get_last_index() + 1 - distance;
+    return distance < wrapped ? distance : wrapped;
+}
+
+static list_label_t *find_label(uint16_t index) {
+    if (virtual_list.generation != get_generation()) {
+        // the items changed since the labels were rendered
+        reset_labels();
+    }
+    for (uint8_t i = 0; i < VIRTUAL_LIST_CACHE_SIZE; i++) {
+        if (virtual_list.labels[i].valid && virtual_list.labels[i].index == index) {
+            return &virtual_list.labels[i];
+        }
+    }
+    return NULL;
+}
+
+static list_label_t *get_label(uint16_t index) {
+    list_label_t *label = find_label(index);
+    if (label == NULL) {
+        // replace the label furthest from the current item
+        label = &virtual_list.labels[0];
+        for (uint8_t i = 0; i < VIRTUAL_LIST_CACHE_SIZE; i++) {
+            if (!virtual_list.labels[i].valid) {
+                label = &virtual_list.labels[i];
+                break;
+            }
+            if (get_distance_to_current(virtual_list.labels[i].index) >
+                get_distance_to_current(label->index)) {
+                label = &virtual_list.labels[i];
+            }
+        }
+        label->valid = true;
+        label->index = index;
+        label->value = virtual_list.source.render(index, label->line_1, label->line_2);
+    }
+    return label;
+}
+
+/* index reached from the current one, pages stop at the ends of the list instead of looping */
+static uint16_t get_scrolled_index(bool forward, bool by_page) {
+    uint16_t current = virtual_list.current;
+    uint16_t last = get_last_index();
+    if (!by_page) {
+        if (forward) {
+            return current < last ? current + 1 : 0;
+        }
+        return current > 0 ? current - 1 : last;
+    }
+    if (virtual_list.source.page != NULL) {
+        return virtual_list.source.page(current, forward);
+    }
+    if (forward) {
+        return last - current > SCROLL_PAGE_SIZE ? current + SCROLL_PAGE_SIZE : last;
+    }
+    return current > SCROLL_PAGE_SIZE ? current - SCROLL_PAGE_SIZE : 0;
+}
+
+static void display_current_item(void) {
+    const list_label_t *label = get_label(virtual_list.current);
+    strcpy(virtual_list_line_1, label->line_1);
+    strcpy(virtual_list_line_2, label->line_2);
+    if (virtual_list.source.focus != NULL && virtual_list.scroll_repeats == 0) {
+        virtual_list.source.focus(virtual_list.current, label->value);
+    }
+}
+
+static void select_current_item(void) {
+    const list_label_t *label = get_label(virtual_list.current);
+    virtual_list.source.select(virtual_list.current, label->value);
+}
+
+/*
+ * Replaces the flow navigation: a held button keeps scrolling, one item per repeat event
+ * then one page per repeat event. Only the two lines of the current step are redrawn.
+ */
+static unsigned int virtual_list_button(unsigned int button_mask,
+                                        unsigned int button_mask_counter) {
+    UNUSED(button_mask_counter);
+
+    switch (button_mask) {
+        case BUTTON_EVT_RELEASED | BUTTON_LEFT | BUTTON_RIGHT:
+            select_current_item();
+            return 0;
+
+        case BUTTON_EVT_FAST | BUTTON_LEFT:
+        case BUTTON_EVT_FAST | BUTTON_RIGHT:
+            virtual_list.scroll_repeats++;
+            virtual_list.current =
+                get_scrolled_index((button_mask & BUTTON_RIGHT) != 0,
+                                   virtual_list.scroll_repeats > SCROLL_PAGE_AFTER_REPEATS);
+            break;
+
+        case BUTTON_EVT_RELEASED | BUTTON_LEFT:
+        case BUTTON_EVT_RELEASED | BUTTON_RIGHT:
+            // the release ending a held button only settles on the item reached
+            if (virtual_list.scroll_repeats == 0) {
+                virtual_list.current = get_scrolled_index((button_mask & BUTTON_RIGHT) != 0, false);
+            }
+            virtual_list.scroll_repeats = 0;
+            break;
+
+        default:
+            return 0;
+    }
+    display_current_item();
+    ux_stack_display(0);
+    return 0;
+}
+
+static void take_buttons(void) {
+    virtual_list.scroll_repeats = 0;
+    G_ux.stack[0].button_push_callback = virtual_list_button;
+}
+
+/* the flow engine only reaches the borders when entering the flow, or when navigating without
+ * our buttons handler */
+static void display_next_item(bool is_upper_border) {
+    if (is_upper_border) {
+        if (!virtual_list.entering) {
+            virtual_list.current = get_scrolled_index(false, false);
+        }
+        virtual_list.entering = false;
+        ux_flow_next();
+    } else {
+        virtual_list.current = get_scrolled_index(true, false);
+        ux_flow_prev();
+    }
+    take_buttons();
+}
+
+void virtual_list_display(const virtual_list_source_t *source, uint16_t current) {
+    virtual_list.source.count = (uint16_t(*)(void)) PIC(source->count);
+    virtual_list.source.render = (size_t(*)(uint16_t, char *, char *)) PIC(source->render);
+    virtual_list.source.focus = (void (*)(uint16_t, size_t)) PIC(source->focus);
+    virtual_list.source.select = (void (*)(uint16_t, size_t)) PIC(source->select);
+    virtual_list.source.page = (uint16_t(*)(uint16_t, bool)) PIC(source->page);
+    virtual_list.source.generation = (uint16_t(*)(void)) PIC(source->generation);
+    virtual_list.current = current;
+    reset_labels();
+    virtual_list_redisplay();
+}
+
+void virtual_list_redisplay(void) {
+    list_label_t *label = find_label(virtual_list.current);
+    if (label != NULL) {
+        label->valid = false;
+    }
+    virtual_list.entering = true;
+    ux_flow_init(0, virtual_list_flow, NULL);
+}
+
+uint16_t virtual_list_current(void) {
+    return virtual_list.current;
+}
+
+bool virtual_list_is_displayed(void) {
+    return G_ux.stack_count != 0 && G_ux.stack[0].button_push_callback == virtual_list_button;
+}
+
+/* renders the labels of the items around the displayed one, one per event */
+void virtual_list_on_ticker(void) {
+    if (!virtual_list_is_displayed() || virtual_list.scroll_repeats != 0) {
+        return;
+    }
+    uint16_t neighbours[] = {get_scrolled_index(true, false), get_scrolled_index(false, false)};
+    for (uint8_t i = 0; i < sizeof(neighbours) / sizeof(neighbours[0]); i++) {
+        if (find_label(neighbours[i]) == NULL) {
+            get_label(neighbours[i]);
+            return;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef __VIRTUAL_LIST_H__
+#define __VIRTUAL_LIST_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#define VIRTUAL_LIST_LINE_1_SIZE 16
+#define VIRTUAL_LIST_LINE_2_SIZE 21
+/* rendered labels kept: the current item and its neighbours */
+#define VIRTUAL_LIST_CACHE_SIZE 3
+
+/*
+ * Items of a list, accessed by index. The list wraps around after the last item.
+ */
+typedef struct virtual_list_source_s {
+    uint16_t (*count)(void);
+    /* fills the two lines of the item, the returned value is handed back to focus and select */
+    size_t (*render)(uint16_t index, char *line_1, char *line_2);
+    /* the list stopped on the item, may be NULL */
+    void (*focus)(uint16_t index, size_t value);
+    /* both buttons pressed on the item */
+    void (*select)(uint16_t index, size_t value);
+    /* item reached by a page from index while a button is held, may be NULL for pages of
+     * 10 items, stopping at the ends of the list */
+    uint16_t (*page)(uint16_t index, bool forward);
+    /* changes when rendered items must be rendered again, may be NULL */
+    uint16_t (*generation)(void);
+} virtual_list_source_t;
+
+/*
+ * Two lines list of any number of items, of which only the displayed one and its neighbours
+ * are rendered: the cost of displaying and scrolling does not depend on the list size, as
+ * long as the source gives random access to its items. A held button keeps scrolling, one
+ * item per repeat event then one page per repeat event, and the neighbours of the current
+ * item are rendered ahead during ticker events.
+ */
+void virtual_list_display(const virtual_list_source_t *source, uint16_t current);
+/* displays the list again from the current item, rendering it again */
+void virtual_list_redisplay(void);
+uint16_t virtual_list_current(void);
+/* the list is on screen, not a flow opened from it */
+bool virtual_list_is_displayed(void);
+void virtual_list_on_ticker(void);
+
+#endif
@@ -2,6 +2,8 @@ from .device_exception import DeviceException
 from .types import (UnknownDeviceError,
                     WrongP1P2Error,
                     WrongDataLengthError,
+                    WrongDataError,
+                    EntryNotFoundError,
                     InsNotSupportedError,
                     ClaNotSupportedError,
                     AppNameTooLongError,
@@ -13,6 +15,8 @@ __all__ = [
     "UnknownDeviceError",
     "WrongP1P2Error",
     "WrongDataLengthError",
+    "WrongDataError",
+    "EntryNotFoundError",
     "InsNotSupportedError",
     "ClaNotSupportedError",
     "AppNameTooLongError",
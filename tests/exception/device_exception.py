@@ -8,6 +8,8 @@ class DeviceException(Exception):  # pylint: disable=too-few-public-methods
     exc: Dict[int, Any] = {
         0x6A86: WrongP1P2Error,
         0x6A87: WrongDataLengthError,
+        0x6A80: WrongDataError,
+        0x6A88: EntryNotFoundError,
         0x6D00: InsNotSupportedError,
         0x6E00: ClaNotSupportedError,
         0xB000: AppNameTooLongError,
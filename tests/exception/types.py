@@ -10,6 +10,14 @@ class WrongDataLengthError(Exception):
     pass
 
 
+class WrongDataError(Exception):
+    pass
+
+
+class EntryNotFoundError(Exception):
+    pass
+
+
 class InsNotSupportedError(Exception):
     pass
 
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ *   Password Manager application
+ *   (c) 2017 Ledger
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Host-side check of the GET_PASSWORD command.
+ *
+ * The store holds legacy records, without usage data, as a backup made by an older release
+ * loads them. The password of the first entry is requested, and the usage data written while
+ * the prompt is open upgrades a record, which moves it to the end of the log. Once approved,
+ * the command must return the password of the entry the prompt showed, computed here with
+ * type_password(), and refuse to export anything when the index now leads to another entry.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "globals.h"
+#include "metadata.h"
+#include "entry_index.h"
+#include "entry_usage.h"
+#include "password_typing.h"
+#include "sw.h"
+#include "apdu_handlers/get_password.h"
+#include "host_stubs.h"
+
+static const char *NICKNAMES[] = {"gmail", "github.com", "bank"};
+
+#define NICKNAMES_COUNT (sizeof(NICKNAMES) / sizeof(NICKNAMES[0]))
+#define SETS            0x0F
+
+static char shown[MAX_METANAME + 1];
+static uint8_t response[PASSWORD_LENGTH];
+static size_t response_size;
+static uint16_t response_sw;
+
+void ui_idle() {
+}
+
+void ui_request_user_approval(message_pair_t *msg) {
+    strcpy(shown, msg->second);
+}
+
+int send(const buf_t *buf, uint16_t sw) {
+    memcpy(response, buf->bytes, buf->size);
+    response_size = buf->size;
+    response_sw = sw;
+    return 0;
+}
+
+int send_sw(uint16_t sw) {
+    response_size = 0;
+    response_sw = sw;
+    return 0;
+}
+
+static uint32_t find_entry(const char *nickname) {
+    return entry_index_find(SETS, nickname, strlen(nickname));
+}
+
+/* requests the password of the first entry, lets the usage data of the given entry be written
+ * while the prompt is open, then approves */
+static void export_first_entry(const char *used) {
+    uint8_t index[2] = {0, 0};
+    const buf_t input = {.bytes = index, .size = sizeof(index)};
+    app_state.user_approval = false;
+    get_password(0, 0, &input);
+    entry_usage_record(find_entry(used));
+    entry_usage_flush();
+    app_state.user_approval = true;
+    get_password(0, 0, &input);
+}
+
+static int check_export(const char *used, bool moved) {
+    export_first_entry(used);
+    if (strcmp(shown, NICKNAMES[0]) != 0) {
+        fprintf(stderr, "the prompt showed \"%s\"\n", shown);
+        return 1;
+    }
+    if (moved) {
+        if (response_size != 0 || response_sw != SW_ENTRY_NOT_FOUND) {
+            fprintf(stderr, "a password was exported for another entry than \"%s\"\n", shown);
+            return 1;
+        }
+        return 0;
+    }
+    uint8_t expected[PASSWORD_LENGTH + 1];
+    type_password((uint8_t *) shown,
+                  strlen(shown),
+                  expected,
+                  SETS,
+                  (const uint8_t *) PIC(DEFAULT_MIN_SET),
+                  PASSWORD_LENGTH);
+    if (response_sw != SW_OK || response_size != PASSWORD_LENGTH ||
+        memcmp(response, expected, PASSWORD_LENGTH) != 0) {
+        fprintf(stderr, "the password exported isn't the one of \"%s\"\n", shown);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    nvm_write((void *) &N_storage, NULL, sizeof(N_storage));
+    reset_metadatas();
+    uint32_t offset = 0;
+    for (size_t n = 0; n < NICKNAMES_COUNT; n++) {
+        uint8_t record[3 + MAX_METANAME];
+        size_t len = strlen(NICKNAMES[n]);
+        record[0] = 1 + len;
+        record[1] = META_NONE;
+        record[2] = SETS;
+        memcpy(record + 3, NICKNAMES[n], len);
+        nvm_write((void *) METADATA_PTR(offset), record, 3 + len);
+        offset += 3 + len;
+    }
+    check_metadatas(true);
+    entry_usage_init();
+    entry_index_build();
+
+    // the last entry is upgraded, the first one stays in place
+    failures += check_export(NICKNAMES[NICKNAMES_COUNT - 1], false);
+    // the first entry is upgraded, the second one takes its index
+    failures += check_export(NICKNAMES[0], true);
+
+    printf("\npassword export with usage data written during the prompt: %d failures\n",
+           failures);
+    return failures != 0;
+}
@@ -0,0 +1,260 @@
+/*******************************************************************************
+ *   Password Manager application
+ *   (c) 2017 Ledger
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Host-side HID keystroke simulator.
+ *
+ * Runs type_password() against a capturing io_usb_send_ep(), decodes the recorded report
+ * stream back to text the way a host configured with the same layout would, and checks it
+ * against the password generated for the same nickname, or against the text given to
+ * type_string(). It also reports how many reports are sent per typed character and the
+ * resulting typing time for a given polling interval.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+#include "hid_mapping.h"
+#include "password_typing.h"
+#include "host_stubs.h"
+
+#define DEFAULT_POLL_INTERVAL_MS 10
+#define PASSWORD_SIZE            20
+
+#define KEY_ENTER     0x28
+#define KEY_CAPS_LOCK 0x39
+
+#define UNKNOWN_KEY     '\x01'
+#define UNEXPECTED_DEAD '\x02'
+
+static const char *LAYOUT_NAMES[] = {"", "qwerty", "qwerty-intl", "azerty"};
+
+static const char *NICKNAMES[] = {"gmail",
+                                  "github.com",
+                                  "aseedoflengthequal20",
+                                  "aSeedOfLengthEqual20",
+                                  "bank",
+                                  "root@jumphost",
+                                  "wikipedia.org",
+                                  "x"};
+
+static const uint8_t CHARSETS[] = {0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF};
+
+/* (modifiers << 8 | keycode) -> ascii, 0 when the combination types nothing known */
+static char reverse_map[0x10000];
+
+typedef struct stats_s {
+    unsigned long passwords;
+    unsigned long chars;
+    unsigned long reports;
+    unsigned long failures;
+} stats_t;
+
+static int build_reverse_map(hid_mapping_t layout) {
+    uint8_t report[HID_REPORT_LENGTH];
+    int ambiguities = 0;
+
+    memset(reverse_map, 0, sizeof(reverse_map));
+    for (unsigned int c = 0x20; c < 0x7F; c++) {
+        memset(report, 0, sizeof(report));
+        map_char(layout, c, report);
+        uint16_t key = (report[0] << 8) | report[2];
+        if (reverse_map[key] != 0) {
+            fprintf(stderr,
+                    "%s: '%c' and '%c' are typed with the same report (%02X %02X)\n",
+                    LAYOUT_NAMES[layout],
+                    reverse_map[key],
+                    c,
+                    report[0],
+                    report[2]);
+            ambiguities++;
+            continue;
+        }
+        reverse_map[key] = c;
+    }
+    return ambiguities;
+}
+
+static bool is_dead_key(char c) {
+    return c == '"' || c == '\'' || c == '`' || c == '~' || c == '^';
+}
+
+/* Replays the captured reports like a host would, a character being produced on key press */
+static size_t decode_reports(hid_mapping_t layout, bool caps_lock, char *out, size_t out_size) {
+    uint8_t previous[HID_REPORT_LENGTH] = {0};
+    char pending_dead = 0;
+    size_t len = 0;
+
+    for (size_t i = 0; i < G_captured_count; i++) {
+        const uint8_t *report = G_captured_reports[i];
+        for (size_t k = 2; k < HID_REPORT_LENGTH; k++) {
+            uint8_t keycode = report[k];
+            if (keycode == 0 || memchr(previous + 2, keycode, HID_REPORT_LENGTH - 2) != NULL) {
+                continue;
+            }
+            char c;
+            if (keycode == KEY_CAPS_LOCK) {
+                caps_lock = !caps_lock;
+                continue;
+            } else if (keycode == KEY_ENTER) {
+                c = '\n';
+            } else {
+                c = reverse_map[(report[0] << 8) | keycode];
+                if (c == 0) {
+                    c = UNKNOWN_KEY;
+                } else if (caps_lock && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+                    c ^= 0x20;
+                }
+            }
+            if (layout == HID_MAPPING_QWERTY_INTL) {
+                if (pending_dead != 0) {
+                    // a dead key only types itself when followed by a space
+                    c = (c == ' ') ? pending_dead : UNEXPECTED_DEAD;
+                    pending_dead = 0;
+                } else if (is_dead_key(c)) {
+                    pending_dead = c;
+                    continue;
+                }
+            }
+            if (len + 1 < out_size) {
+                out[len++] = c;
+            }
+        }
+        memcpy(previous, report, sizeof(previous));
+    }
+    if (pending_dead != 0 && len + 1 < out_size) {
+        out[len++] = UNEXPECTED_DEAD;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static void run_case(hid_mapping_t layout,
+                     const char *nickname,
+                     uint8_t charsets,
+                     bool caps_lock,
+                     bool press_enter,
+                     stats_t *stats) {
+    uint8_t expected[PASSWORD_SIZE + 2];
+    char decoded[256];
+
+    N_storage.keyboard_layout = layout;
+    N_storage.press_enter_after_typing = press_enter;
+    // the second type_password() call is served by the derivation cache on half of the runs
+    N_storage.cache_recent_passwords = caps_lock;
+    G_led_status = caps_lock ? 2 : 0;
+
+    type_password((uint8_t *) nickname,
+                  strlen(nickname),
+                  expected,
+                  charsets,
+                  DEFAULT_MIN_SET,
+                  PASSWORD_SIZE);
+    if (press_enter) {
+        strcat((char *) expected, "\n");
+    }
+
+    host_capture_reset();
+    type_password((uint8_t *) nickname,
+                  strlen(nickname),
+                  NULL,
+                  charsets,
+                  DEFAULT_MIN_SET,
+                  PASSWORD_SIZE);
+    decode_reports(layout, caps_lock, decoded, sizeof(decoded));
+
+    stats->passwords++;
+    stats->chars += PASSWORD_SIZE;
+    stats->reports += G_captured_count;
+    if (strcmp(decoded, (char *) expected) != 0) {
+        stats->failures++;
+        fprintf(stderr,
+                "%s: \"%s\" charsets 0x%02X caps %d: expected \"%s\", host saw \"%s\"\n",
+                LAYOUT_NAMES[layout],
+                nickname,
+                charsets,
+                caps_lock,
+                expected,
+                decoded);
+    }
+}
+
+/* Every printable character through type_string(), as used for host supplied text */
+static void run_text_case(hid_mapping_t layout, bool caps_lock, stats_t *stats) {
+    uint8_t text[0x7F - 0x20 + 1];
+    char decoded[256];
+
+    for (unsigned int c = 0x20; c < 0x7F; c++) {
+        text[c - 0x20] = c;
+    }
+    text[sizeof(text) - 1] = '\0';
+    N_storage.keyboard_layout = layout;
+    G_led_status = caps_lock ? 2 : 0;
+
+    host_capture_reset();
+    type_string(text, sizeof(text) - 1, false);
+    decode_reports(layout, caps_lock, decoded, sizeof(decoded));
+    if (strcmp(decoded, (char *) text) != 0) {
+        stats->failures++;
+        fprintf(stderr,
+                "%s: caps %d: typed \"%s\", host saw \"%s\"\n",
+                LAYOUT_NAMES[layout],
+                caps_lock,
+                text,
+                decoded);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned long poll_interval_ms = DEFAULT_POLL_INTERVAL_MS;
+    int failures = 0;
+
+    if (argc > 1) {
+        poll_interval_ms = strtoul(argv[1], NULL, 10);
+    }
+
+    printf("%-12s %9s %8s %12s %14s\n", "layout", "passwords", "reports", "reports/char", "ms/password");
+    for (hid_mapping_t layout = HID_MAPPING_QWERTY; layout <= HID_MAPPING_AZERTY; layout++) {
+        stats_t stats = {0};
+
+        failures += build_reverse_map(layout);
+        for (size_t n = 0; n < sizeof(NICKNAMES) / sizeof(NICKNAMES[0]); n++) {
+            for (size_t s = 0; s < sizeof(CHARSETS); s++) {
+                for (int caps_lock = 0; caps_lock < 2; caps_lock++) {
+                    run_case(layout, NICKNAMES[n], CHARSETS[s], caps_lock, n == 0, &stats);
+                }
+            }
+        }
+        run_text_case(layout, false, &stats);
+        run_text_case(layout, true, &stats);
+        failures += stats.failures;
+        printf("%-12s %9lu %8lu %12.2f %14.1f\n",
+               LAYOUT_NAMES[layout],
+               stats.passwords,
+               stats.reports,
+               (double) stats.reports / stats.chars,
+               (double) stats.reports * poll_interval_ms / stats.passwords);
+    }
+
+    if (failures) {
+        fprintf(stderr, "%d mismatch(es)\n", failures);
+        return 1;
+    }
+    return 0;
+}
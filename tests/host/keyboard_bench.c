@@ -0,0 +1,248 @@
+/*******************************************************************************
+ *   Password Manager application
+ *   (c) 2017 Ledger
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Host-side benchmark of the text keyboard wheels.
+ *
+ * Counts the button presses needed to type a set of typical nicknames and validate them,
+ * with the alphabetical wheels the keyboard had before, with the typical frequency order and
+ * quick class of keyboard_order_compute(), and with the order it computes from the same
+ * nicknames once they are stored. A press moves to the neighbouring item or validates the
+ * current one (both buttons), and the keyboard behaves as src/keyboards/text_keyboard.c: a
+ * class starts on its first item, stays on the last typed character, and the classes wheel
+ * comes back on the class left. The shortest way is taken for each character; completions
+ * are not used.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "globals.h"
+#include "metadata.h"
+#include "keyboard_order.h"
+
+#define MAX_CLASSES 4
+
+static const char *NICKNAMES[] = {"gmail.com",
+                                  "github.com",
+                                  "google",
+                                  "amazon.com",
+                                  "facebook",
+                                  "twitter.com",
+                                  "linkedin.com",
+                                  "netflix",
+                                  "paypal.com",
+                                  "dropbox",
+                                  "stackoverflow.com",
+                                  "reddit.com",
+                                  "wikipedia.org",
+                                  "bank",
+                                  "mybank-online.fr",
+                                  "root@jumphost",
+                                  "admin@router",
+                                  "wifi-home",
+                                  "work-vpn",
+                                  "alice@example.com",
+                                  "bob.smith@corp.net",
+                                  "aws-console",
+                                  "steam",
+                                  "spotify",
+                                  "outlook.com",
+                                  "nas-backup",
+                                  "server-01",
+                                  "gitlab.company.io",
+                                  "jira.corp",
+                                  "ebay.de"};
+
+/* the store is only read here */
+void derivation_cache_wipe(void) {
+}
+
+typedef struct wheels_s {
+    const char *name;
+    size_t classes_count;
+    const char *classes[MAX_CLASSES];
+} wheels_t;
+
+typedef struct typing_state_s {
+    bool on_classes;     // on the classes wheel, else on the characters of current_class
+    size_t current;      // current item of the wheel
+    size_t current_class;
+    size_t typed;
+} typing_state_t;
+
+static size_t distance(size_t from, size_t to, size_t size) {
+    size_t forward = (to + size - from) % size;
+    return forward < size - forward ? forward : size - forward;
+}
+
+/* characters, then backspace, validate and back to classes once a character is typed */
+static size_t wheel_size(const wheels_t *wheels, size_t char_class, size_t typed) {
+    return strlen(wheels->classes[char_class]) + (typed ? 3 : 1);
+}
+
+static size_t back_to_classes_item(const wheels_t *wheels, size_t char_class, size_t typed) {
+    return strlen(wheels->classes[char_class]) + (typed ? 2 : 0);
+}
+
+/* classes, then backspace and validate once a character is typed */
+static size_t classes_wheel_size(const wheels_t *wheels, size_t typed) {
+    return wheels->classes_count + (typed ? 2 : 0);
+}
+
+/* presses to reach the classes wheel, leaving the state on it */
+static size_t go_to_classes(const wheels_t *wheels, typing_state_t *state) {
+    if (state->on_classes) {
+        return 0;
+    }
+    size_t presses = distance(state->current,
+                              back_to_classes_item(wheels, state->current_class, state->typed),
+                              wheel_size(wheels, state->current_class, state->typed)) +
+                     1;
+    state->on_classes = true;
+    state->current = state->current_class;
+    return presses;
+}
+
+static size_t type_char(const wheels_t *wheels, typing_state_t *state, char c) {
+    size_t best = (size_t) -1;
+    typing_state_t best_state = *state;
+
+    for (size_t k = 0; k < wheels->classes_count; k++) {
+        const char *found = strchr(wheels->classes[k], c);
+        if (found == NULL) {
+            continue;
+        }
+        typing_state_t next = *state;
+        size_t position = found - wheels->classes[k];
+        size_t presses = 0;
+        if (next.on_classes || next.current_class != k) {
+            presses += go_to_classes(wheels, &next);
+            presses += distance(next.current, k, classes_wheel_size(wheels, next.typed)) + 1;
+            next.on_classes = false;
+            next.current_class = k;
+            next.current = 0;
+        }
+        presses += distance(next.current, position, wheel_size(wheels, k, next.typed)) + 1;
+        next.current = position;
+        next.typed++;
+        if (presses < best) {
+            best = presses;
+            best_state = next;
+        }
+    }
+    if (best == (size_t) -1) {
+        fprintf(stderr, "%s: no class for '%c'\n", wheels->name, c);
+        return 0;
+    }
+    *state = best_state;
+    return best;
+}
+
+static size_t validate(const wheels_t *wheels, typing_state_t *state) {
+    size_t validate_item = strlen(wheels->classes[state->current_class]) + 1;
+    size_t in_class = distance(state->current,
+                               validate_item,
+                               wheel_size(wheels, state->current_class, state->typed)) +
+                      1;
+    typing_state_t classes = *state;
+    size_t from_classes = go_to_classes(wheels, &classes);
+    from_classes += distance(classes.current,
+                             wheels->classes_count + 1,
+                             classes_wheel_size(wheels, classes.typed)) +
+                    1;
+    return in_class < from_classes ? in_class : from_classes;
+}
+
+static size_t type_nickname(const wheels_t *wheels, const char *nickname) {
+    typing_state_t state = {true, 0, 0, 0};
+    size_t presses = 0;
+    for (const char *c = nickname; *c != '\0'; c++) {
+        presses += type_char(wheels, &state, *c);
+    }
+    return presses + validate(wheels, &state);
+}
+
+static double run(const wheels_t *wheels, size_t chars) {
+    size_t presses = 0;
+    for (size_t n = 0; n < sizeof(NICKNAMES) / sizeof(NICKNAMES[0]); n++) {
+        presses += type_nickname(wheels, NICKNAMES[n]);
+    }
+    double average = (double) presses / (sizeof(NICKNAMES) / sizeof(NICKNAMES[0]));
+    printf("%-14s %15.1f %11.2f\n", wheels->name, average, (double) presses / chars);
+    return average;
+}
+
+static void store_nicknames(void) {
+    uint32_t offset = 0;
+    nvm_write((void *) &N_storage, NULL, sizeof(N_storage));
+    for (size_t n = 0; n < sizeof(NICKNAMES) / sizeof(NICKNAMES[0]); n++) {
+        uint8_t record[3 + MAX_METANAME];
+        size_t len = strlen(NICKNAMES[n]);
+        record[0] = 1 + len;
+        record[1] = META_NONE;
+        record[2] = 0x0F;
+        memcpy(record + 3, NICKNAMES[n], len);
+        nvm_write((void *) METADATA_PTR(offset), record, 3 + len);
+        offset += 3 + len;
+    }
+}
+
+int main(void) {
+    static const char symbols[] = "0123456789 '\"`&/?!:;.,~*$=+-[](){}<>\\_#@|%";
+    const wheels_t alphabetical = {
+        "alphabetical",
+        3,
+        {"abcdefghijklmnopqrstuvwxyz", "ABCDEFGHIJKLMNOPQRSTUVWXYZ", symbols}};
+    keyboard_order_t typical;
+    keyboard_order_t adaptive;
+    size_t chars = 0;
+
+    for (size_t n = 0; n < sizeof(NICKNAMES) / sizeof(NICKNAMES[0]); n++) {
+        chars += strlen(NICKNAMES[n]);
+    }
+
+    nvm_write((void *) &N_storage, NULL, sizeof(N_storage));
+    keyboard_order_compute(&typical);
+    store_nicknames();
+    keyboard_order_compute(&adaptive);
+
+    const wheels_t frequency = {
+        "frequency",
+        4,
+        {typical.lowercase, typical.uppercase, symbols, typical.quick}};
+    const wheels_t adapted = {
+        "adaptive",
+        4,
+        {adaptive.lowercase, adaptive.uppercase, symbols, adaptive.quick}};
+
+    printf("%-14s %15s %11s\n", "wheels", "presses/entry", "presses/char");
+    double before = run(&alphabetical, chars);
+    double after = run(&frequency, chars);
+    double adapted_after = run(&adapted, chars);
+    printf("typical order: %s %s, nicknames order: %s %s\n",
+           typical.lowercase,
+           typical.quick,
+           adaptive.lowercase,
+           adaptive.quick);
+
+    if (after >= before || adapted_after >= before) {
+        fprintf(stderr, "the frequency ordered wheels do not save presses\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,734 @@
+/*******************************************************************************
+ *   Password Manager application
+ *   (c) 2017 Ledger
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+
+/*
+ * Host-side checks of the metadata store.
+ *
+ * Every nickname of a typical set must unpack to itself, then the store is filled with these
+ * nicknames through write_metadata() until it is full, and every stored nickname must read
+ * back unchanged. Prints the number of entries the store holds with plain and with packed
+ * nicknames (the plain figure is computed from the record sizes).
+ *
+ * Then three quarters of the store are filled and the entries are replaced one after the
+ * other, the oldest being erased before each new one is written, first compacting before
+ * every write as the store used to, then with the compactions only done when the free space
+ * runs out, and last with a few background compaction steps after each write. Prints the flash
+ * page programs of the store and of its header page (the settings and the entries count) and
+ * the writes which had to compact for each, and checks the entries read back in order.
+ *
+ * Then a compaction, and the background compaction steps, are interrupted by a power loss at
+ * each of their flash writes in turn, the interrupted write being torn, and every entry must
+ * be found after recover_metadata().
+ *
+ * Then entries are written and erased with a power loss at each of their flash writes: the
+ * start up check must rewrite the digest when the interrupted write left it stale, and leave
+ * the entries count right. A nickname byte is then corrupted, the full check must end the log
+ * before its entry; and a corrupted length must end it there too, without writing the records
+ * after it.
+ *
+ * Then a load with a corrupted record must be rejected, and a load interrupted by a power loss
+ * at each of its flash writes must leave either all the previous entries or all the loaded
+ * ones.
+ *
+ * Then an entry written again must be refused, and a load of the entries written twice must
+ * leave each entry once after erase_duplicate_metadatas().
+ *
+ * Then the group of a legacy entry is changed with the store full and the usage data of an
+ * earlier legacy entry pending: the compaction writing that data moves the earlier entry, and
+ * the group must still be set on the entry asked for, every other entry being kept.
+ *
+ * Then the statistics of the store must account for the erased records, and count the
+ * compaction reclaiming them and the bytes written, before and after their flush.
+ *
+ * Last, a store of legacy records is migrated to the current format with a power loss at each
+ * of the flash writes of the migration in turn, the migration going on when the device starts
+ * again: every entry must read back unchanged, in the current format, with the digest right
+ * after the start up check.
+ * Prints the length of the log before and after the migration.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "globals.h"
+#include "metadata.h"
+#include "nickname_codec.h"
+#include "entry_index.h"
+#include "entry_usage.h"
+#include "store_stats.h"
+#include "host_stubs.h"
+
+#define CHURN_CYCLES 2000
+/* ticker events of background compaction between two entry replacements */
+#define IDLE_STEPS 8
+
+static const char *NICKNAMES[] = {"gmail.com",
+                                  "github.com",
+                                  "google",
+                                  "amazon.com",
+                                  "facebook",
+                                  "twitter.com",
+                                  "linkedin.com",
+                                  "netflix",
+                                  "paypal.com",
+                                  "dropbox",
+                                  "stackoverflow.com",
+                                  "reddit.com",
+                                  "wikipedia.org",
+                                  "bank",
+                                  "mybank-online.fr",
+                                  "root@jumphost",
+                                  "admin@router",
+                                  "wifi-home",
+                                  "work-vpn",
+                                  "alice@example.com",
+                                  "bob.smith@corp.net",
+                                  "aws-console",
+                                  "steam",
+                                  "spotify",
+                                  "outlook.com",
+                                  "nas-backup",
+                                  "server-01",
+                                  "gitlab.company.io",
+                                  "jira.corp",
+                                  "ebay.de",
+                                  "Office 365",
+                                  "login.microsoft",
+                                  "mail.ovh.net",
+                                  "www.impots.gouv.fr",
+                                  "cloud.home:8443",
+                                  "Crédit Agricole"};
+
+#define NICKNAMES_COUNT (sizeof(NICKNAMES) / sizeof(NICKNAMES[0]))
+
+void derivation_cache_wipe(void) {
+}
+
+static int check_round_trips(void) {
+    int failures = 0;
+    for (size_t n = 0; n < NICKNAMES_COUNT; n++) {
+        uint8_t packed[MAX_METANAME];
+        char unpacked[MAX_METANAME];
+        size_t len = strlen(NICKNAMES[n]);
+        uint8_t packed_len = nickname_pack(NICKNAMES[n], len, packed, sizeof(packed));
+        if (packed_len == 0) {
+            continue;  // stored as is
+        }
+        uint8_t unpacked_len = nickname_unpack(packed, packed_len, unpacked, sizeof(unpacked));
+        if (packed_len >= len || unpacked_len != len || memcmp(unpacked, NICKNAMES[n], len)) {
+            fprintf(stderr, "round trip failed for \"%s\"\n", NICKNAMES[n]);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static void write_nickname(const char *nickname, uint8_t sets) {
+    uint8_t data[1 + MAX_METANAME];
+    size_t len = strlen(nickname);
+    data[0] = sets;
+    memcpy(data + 1, nickname, len);
+    write_metadata(data, 1 + len);
+}
+
+static size_t page_of(const volatile void *address) {
+    return (uintptr_t) address / HOST_NVM_PAGE_SIZE -
+           (uintptr_t) &N_storage_real / HOST_NVM_PAGE_SIZE;
+}
+
+/* nickname of the nth entry written, from the start of the churn */
+static const char *churn_nickname(size_t n) {
+    return NICKNAMES[(n * 7) % NICKNAMES_COUNT];
+}
+
+/* writes the nth entry, the copies of a nickname differ by their charsets as duplicates are
+ * refused */
+static void write_entry(size_t n) {
+    write_nickname(churn_nickname(n), 1 + n / NICKNAMES_COUNT);
+}
+
+/* when the entries are compacted during the churn */
+typedef enum { COMPACT_EAGER, COMPACT_WHEN_FULL, COMPACT_WHEN_IDLE } compaction_mode_e;
+
+static int churn(const char *name, compaction_mode_e mode) {
+    reset_metadatas();
+    size_t written = 0;
+    while (find_free_metadata() < MAX_METADATAS * 3 / 4) {
+        write_entry(written++);
+    }
+    host_nvm_reset_counters();
+    unsigned int full_writes = 0;
+    for (size_t cycle = 0; cycle < CHURN_CYCLES; cycle++) {
+        erase_metadata(get_metadata(0));
+        if (mode == COMPACT_EAGER) {
+            compact_metadata();
+        }
+        uint32_t free_before = find_free_metadata();
+        compaction_postpone();
+        write_entry(written++);
+        // the free space only moves back when the write had to compact
+        if (find_free_metadata() < free_before) {
+            full_writes++;
+        }
+        if (mode == COMPACT_WHEN_IDLE) {
+            for (int tick = 0; tick < COMPACTION_IDLE_TICKS + IDLE_STEPS; tick++) {
+                compaction_on_ticker();
+            }
+        }
+    }
+
+    int failures = 0;
+    size_t n = written - N_storage.metadata_count;
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset), n++) {
+        char stored[MAX_METANAME + 1];
+        get_metadata_nickname(offset, stored);
+        if (strcmp(stored, churn_nickname(n)) != 0) {
+            fprintf(stderr, "%s: entry %zu reads \"%s\"\n", name, n, stored);
+            failures++;
+        }
+    }
+
+    uint32_t total = 0;
+    uint32_t max = 0;
+    size_t first = page_of(METADATA_PTR(0));
+    size_t last = page_of(METADATA_PTR(MAX_METADATAS - 1));
+    for (size_t page = first; page <= last; page++) {
+        total += G_nvm_page_programs[page];
+        max = G_nvm_page_programs[page] > max ? G_nvm_page_programs[page] : max;
+    }
+    printf("%-8s %14u %14.1f %9u %12u %12u\n",
+           name,
+           total,
+           (double) total / (last - first + 1),
+           max,
+           G_nvm_page_programs[page_of(&N_storage.metadata_count)],
+           full_writes);
+    return failures;
+}
+
+/* live nicknames in log order, separated by newlines */
+static void list_nicknames(char *list, size_t size) {
+    list[0] = '\0';
+    for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+         offset = metadata_next_entry(offset)) {
+        char nickname[MAX_METANAME + 1];
+        get_metadata_nickname(offset, nickname);
+        strncat(list, nickname, size - strlen(list) - 2);
+        strcat(list, "\n");
+    }
+}
+
+static int interrupt_compaction(const internalStorage_t *before,
+                                const char *expected,
+                                size_t expected_count,
+                                bool background) {
+    static char recovered[MAX_METADATAS * 2];
+    volatile int failures = 0;
+    volatile bool completed = false;
+    volatile unsigned int writes = 0;
+    while (!completed) {
+        memcpy((void *) &N_storage, before, sizeof(*before));
+        // the start up check forgets where the previous run stopped
+        check_metadatas(false);
+        entry_index_build();
+        host_nvm_lose_power_after(++writes);
+        if (setjmp(G_nvm_power_loss) == 0) {
+            if (background) {
+                while (compact_metadata_step()) {
+                }
+            } else {
+                compact_metadata();
+            }
+            host_nvm_lose_power_after(0);
+            completed = true;
+        }
+        // the device restarts
+        recover_metadata();
+        list_nicknames(recovered, sizeof(recovered));
+        if (strcmp(recovered, expected) != 0 || N_storage.metadata_count != expected_count) {
+            fprintf(stderr, "power loss at write %u: entries differ\n", writes);
+            failures++;
+        }
+    }
+    printf("%spower loss at each of the %u writes of a %s compaction: %d failures\n",
+           background ? "" : "\n",
+           writes - 1,
+           background ? "background" : "whole",
+           failures);
+    return failures;
+}
+
+static int check_power_losses(void) {
+    static internalStorage_t before;
+    static char expected[MAX_METADATAS * 2];
+    int failures = 0;
+
+    reset_metadatas();
+    for (size_t n = 0; find_free_metadata() < MAX_METADATAS * 3 / 4; n++) {
+        write_entry(n);
+    }
+    for (size_t nth = 0; nth < N_storage.metadata_count; nth += 2) {
+        erase_metadata(get_metadata(nth));
+    }
+    list_nicknames(expected, sizeof(expected));
+    size_t expected_count = N_storage.metadata_count;
+    memcpy(&before, (const void *) &N_storage, sizeof(before));
+
+    for (int background = 0; background < 2; background++) {
+        failures += interrupt_compaction(&before, expected, expected_count, background);
+    }
+    return failures;
+}
+
+/* a reset leaves nothing behind in either bank, whichever one was active */
+static int check_reset(void) {
+    int failures = 0;
+    for (int compactions = 0; compactions < 2; compactions++) {
+        reset_metadatas();
+        for (size_t n = 0; n < 16; n++) {
+            write_entry(n);
+        }
+        for (int i = 0; i < compactions; i++) {
+            erase_metadata(get_metadata(0));
+            compact_metadata();
+        }
+        uint8_t active_bank = N_storage.active_bank;
+        reset_metadatas();
+        for (size_t i = 0; i < sizeof(N_storage.metadata_banks); i++) {
+            if (((const volatile uint8_t *) N_storage.metadata_banks)[i] != 0) {
+                fprintf(stderr, "reset from bank %u: byte %zu left\n", active_bank, i);
+                failures++;
+                break;
+            }
+        }
+        if (N_storage.active_bank != 0 || N_storage.metadata_version != METADATA_VERSION ||
+            N_storage.metadata_count != 0 || N_storage.metadata_digest != 0) {
+            fprintf(stderr, "reset from bank %u: header not reset\n", active_bank);
+            failures++;
+        }
+    }
+    printf("reset from either bank: %d failures\n", failures);
+    return failures;
+}
+
+/* power loss at each write of an append then of an erasure, then a corrupted nickname */
+static int check_digest(void) {
+    static internalStorage_t before;
+    volatile int failures = 0;
+    volatile unsigned int stale = 0;
+
+    reset_metadatas();
+    for (size_t n = 0; n < 16; n++) {
+        write_entry(n);
+    }
+    for (int erase = 0; erase < 2; erase++) {
+        memcpy(&before, (const void *) &N_storage, sizeof(before));
+        volatile bool completed = false;
+        for (volatile unsigned int writes = 1; !completed; writes++) {
+            memcpy((void *) &N_storage, &before, sizeof(before));
+            entry_index_build();
+            host_nvm_lose_power_after(writes);
+            if (setjmp(G_nvm_power_loss) == 0) {
+                if (erase) {
+                    erase_metadata(get_metadata(3));
+                } else {
+                    write_nickname("interrupted", 0x0F);
+                }
+                host_nvm_lose_power_after(0);
+                completed = true;
+            }
+            // the device restarts
+            size_t live = 0;
+            for (uint32_t offset = metadata_first_entry(); offset != METADATA_END;
+                 offset = metadata_next_entry(offset)) {
+                live++;
+            }
+            host_nvm_reset_counters();
+            uint16_t erased = check_metadatas(false);
+            // the summary page is only written when the digest was stale
+            stale += G_nvm_page_programs[page_of(&N_storage.metadata_count)] != 0;
+            if (erased != 0 || N_storage.metadata_count != live || check_metadatas(false) != 0) {
+                fprintf(stderr, "power loss at write %u: entries count differs\n", writes);
+                failures++;
+            }
+        }
+    }
+
+    // the checksum is not updated with the nickname, which then reads differently
+    uint32_t offset = get_metadata(5);
+    uint8_t corrupted = METADATA_NICKNAME(offset)[0] ^ 0x04;
+    nvm_write((void *) METADATA_NICKNAME(offset), &corrupted, 1);
+    size_t count = N_storage.metadata_count;
+    // its length can't be trusted either, the log ends before it
+    uint16_t dropped = check_metadatas(true);
+    if (dropped != count - 5 || find_free_metadata() != offset || METADATA_DATALEN(offset) != 0 ||
+        N_storage.metadata_count != 5 || check_metadatas(false) != 0) {
+        fprintf(stderr, "corrupted nickname: %u entries dropped\n", dropped);
+        failures++;
+    }
+    // a corrupted length must not lead the check into the following records
+    reset_metadatas();
+    for (size_t n = 0; n < 20; n++) {
+        write_entry(n);
+    }
+    static uint8_t tail[MAX_METADATAS];
+    offset = get_metadata(5);
+    uint32_t end = find_free_metadata();
+    memcpy(tail, (const void *) METADATA_PTR(offset), end - offset);
+    uint8_t length = METADATA_DATALEN(offset) + 3;
+    nvm_write((void *) METADATA_PTR(offset), &length, 1);
+    dropped = check_metadatas(true);
+    if (dropped == 0 || N_storage.metadata_count != 5 ||
+        memcmp(tail + 2, (const void *) METADATA_PTR(offset + 2), end - offset - 2) != 0) {
+        fprintf(stderr, "corrupted length: %u entries dropped, records overwritten\n", dropped);
+        failures++;
+    }
+    printf("\npower loss at each write of an entry change: %u stale digests, %d failures\n",
+           stale,
+           failures);
+    return failures;
+}
+
+/* loads the image in chunks as the LOAD_METADATAS command does */
+static error_type_t load_image(const uint8_t *image, size_t size) {
+    start_metadatas_load();
+    for (size_t sent = 0; sent < size; sent += 250) {
+        size_t len = size - sent < 250 ? size - sent : 250;
+        error_type_t err = write_metadatas_chunk(image + sent, len);
+        if (err != OK) {
+            return err;
+        }
+    }
+    return commit_metadatas_load();
+}
+
+static int check_loads(void) {
+    static internalStorage_t before;
+    static uint8_t image[MAX_METADATAS];
+    static char previous[MAX_METADATAS * 2];
+    static char loaded[MAX_METADATAS * 2];
+    static char listed[MAX_METADATAS * 2];
+    volatile int failures = 0;
+
+    reset_metadatas();
+    for (size_t n = 0; n < 40; n++) {
+        write_entry(n * 3);
+    }
+    memcpy(image, (const void *) METADATA_PTR(0), sizeof(image));
+    list_nicknames(loaded, sizeof(loaded));
+    reset_metadatas();
+    for (size_t n = 0; n < 30; n++) {
+        write_entry(n);
+    }
+    list_nicknames(previous, sizeof(previous));
+    memcpy(&before, (const void *) &N_storage, sizeof(before));
+
+    // the checksum of the third record no longer matches
+    size_t third = 2 + image[0] + 2 + image[2 + image[0]];
+    image[third + 3] ^= 0x01;
+    error_type_t err = load_image(image, sizeof(image));
+    image[third + 3] ^= 0x01;
+    list_nicknames(listed, sizeof(listed));
+    if (err == OK || strcmp(listed, previous) != 0) {
+        fprintf(stderr, "corrupted load: error %d, entries changed\n", err);
+        failures++;
+    }
+
+    volatile bool completed = false;
+    volatile unsigned int writes = 0;
+    while (!completed) {
+        memcpy((void *) &N_storage, &before, sizeof(before));
+        host_nvm_lose_power_after(++writes);
+        if (setjmp(G_nvm_power_loss) == 0) {
+            load_image(image, sizeof(image));
+            host_nvm_lose_power_after(0);
+            completed = true;
+        }
+        // the device restarts
+        recover_metadata();
+        check_metadatas(false);
+        list_nicknames(listed, sizeof(listed));
+        size_t listed_count = 0;
+        for (const char *c = listed; *c != '\0'; c++) {
+            listed_count += *c == '\n';
+        }
+        bool kept = !completed && strcmp(listed, previous) == 0;
+        if ((!kept && strcmp(listed, loaded) != 0) || N_storage.metadata_count != listed_count) {
+            fprintf(stderr, "power loss at write %u of a load: entries differ\n", writes);
+            failures++;
+        }
+    }
+    printf("power loss at each of the %u writes of a load: %d failures\n", writes - 1, failures);
+    return failures;
+}
+
+static int check_duplicates(void) {
+    static uint8_t image[MAX_METADATAS];
+    static char expected[MAX_METADATAS * 2];
+    static char deduplicated[MAX_METADATAS * 2];
+    int failures = 0;
+
+    reset_metadatas();
+    for (size_t n = 0; n < 50; n++) {
+        write_entry(n);
+    }
+    list_nicknames(expected, sizeof(expected));
+    uint8_t data[1 + MAX_METANAME];
+    size_t len = strlen(churn_nickname(7));
+    data[0] = 1 + 7 / NICKNAMES_COUNT;
+    memcpy(data + 1, churn_nickname(7), len);
+    if (write_metadata(data, 1 + len) != ERR_DUPLICATE_METADATA) {
+        fprintf(stderr, "duplicate entry written\n");
+        failures++;
+    }
+    data[0] ^= 0x80;
+    if (write_metadata(data, 1 + len) != OK) {
+        fprintf(stderr, "entry with other charsets refused\n");
+        failures++;
+    }
+    erase_metadata(get_metadata(50));
+
+    // the whole log twice, as an import run again
+    size_t log_len = find_free_metadata();
+    memset(image, 0, sizeof(image));
+    memcpy(image, (const void *) METADATA_PTR(0), log_len);
+    memcpy(image + log_len, (const void *) METADATA_PTR(0), log_len);
+    uint16_t duplicates = 0;
+    if (load_image(image, 2 * log_len) == OK) {
+        entry_index_build();
+        duplicates = erase_duplicate_metadatas();
+    }
+    list_nicknames(deduplicated, sizeof(deduplicated));
+    if (duplicates != 50 || strcmp(deduplicated, expected) != 0) {
+        fprintf(stderr, "load twice: %u duplicates erased\n", duplicates);
+        failures++;
+    }
+    printf("\nentries loaded twice: %u duplicates erased, %d failures\n", duplicates, failures);
+    return failures;
+}
+
+/* writes a record without usage data, as the first releases did, returns the next offset */
+static uint32_t write_legacy(uint32_t offset, const char *nickname, uint8_t kind) {
+    uint8_t record[3 + MAX_METANAME];
+    size_t len = strlen(nickname);
+    record[0] = 1 + len;
+    record[1] = kind;
+    record[2] = 0x0F;
+    memcpy(record + 3, nickname, len);
+    nvm_write((void *) METADATA_PTR(offset), record, 3 + len);
+    return offset + 3 + len;
+}
+
+static int check_group_change(void) {
+    static const char *used = "ab";
+    static const char *target = "zq-xv.target-entry";
+    int failures = 0;
+
+    reset_metadatas();
+    uint32_t offset = write_legacy(0, used, META_NONE);
+    offset = write_legacy(offset, target, META_NONE);
+    for (size_t n = 0; offset < MAX_METADATAS - 64; n++) {
+        offset = write_legacy(offset, churn_nickname(n), n % 5 == 4 ? META_ERASED : META_NONE);
+    }
+    // erased records up to the room for the upgraded copy of the short entry, which is too
+    // small for the tagged copy of the target
+    for (uint32_t records = 3; records > 0; records--) {
+        char padding[MAX_METANAME + 1];
+        size_t len = (MAX_METADATAS - 16 - offset) / records - 3;
+        memset(padding, 'p', len);
+        padding[len] = '\0';
+        offset = write_legacy(offset, padding, META_ERASED);
+    }
+    check_metadatas(true);
+    entry_usage_init();
+    entry_index_build();
+    size_t count = N_storage.metadata_count;
+
+    entry_usage_record(entry_index_find(0x0F, used, strlen(used)));
+    error_type_t err = set_metadata_group(entry_index_find(0x0F, target, strlen(target)), 3);
+    uint32_t changed = entry_index_find(0x0F, target, strlen(target));
+    if (err != OK || changed == METADATA_END || METADATA_GROUP(changed) != 3 ||
+        entry_index_group_count(3) != 1 || N_storage.metadata_count != count) {
+        fprintf(stderr, "group change: error %d, %u entries in the group\n",
+                err, entry_index_group_count(3));
+        failures++;
+    }
+    for (uint32_t entry = metadata_first_entry(); entry != METADATA_END;
+         entry = metadata_next_entry(entry)) {
+        count--;
+    }
+    if (count != 0 || entry_index_find(0x0F, used, strlen(used)) == METADATA_END) {
+        fprintf(stderr, "group change: entries lost\n");
+        failures++;
+    }
+    printf("\ngroup change of a full store with usage data pending: %d failures\n", failures);
+    return failures;
+}
+
+static int check_stats(void) {
+    int failures = 0;
+    reset_metadatas();
+    for (size_t n = 0; n < 10; n++) {
+        write_entry(n);
+    }
+    uint32_t erased_bytes = 0;
+    for (size_t nth = 0; nth < 3; nth++) {
+        erased_bytes += METADATA_TOTAL_LEN(get_metadata(nth));
+        erase_metadata(get_metadata(nth));
+    }
+    store_stats_t before;
+    store_stats_get(&before);
+    if (before.entries != 7 || before.erased_bytes != erased_bytes ||
+        before.free_bytes != MAX_METADATAS - find_free_metadata() ||
+        before.fragmentation != erased_bytes * 1000 / (erased_bytes + before.free_bytes)) {
+        fprintf(stderr, "stats: %u entries, %u erased bytes, %u free bytes\n",
+                before.entries, before.erased_bytes, before.free_bytes);
+        failures++;
+    }
+    compact_metadata();
+    store_stats_flush();
+    store_stats_t after;
+    store_stats_get(&after);
+    if (after.erased_bytes != 0 || after.fragmentation != 0 ||
+        after.free_bytes != before.free_bytes + erased_bytes ||
+        after.compactions != before.compactions + 1 || after.bytes_written <= before.bytes_written ||
+        N_storage.store_counters.bytes_written != after.bytes_written) {
+        fprintf(stderr, "stats after compaction: %u compactions, %u bytes written\n",
+                after.compactions, after.bytes_written);
+        failures++;
+    }
+    printf("\nstore statistics: %u bytes written in %u compactions so far, %d failures\n",
+           after.bytes_written, after.compactions, failures);
+    return failures;
+}
+
+static int check_migrations(void) {
+    static internalStorage_t before;
+    static char expected[MAX_METADATAS * 2];
+    static char migrated[MAX_METADATAS * 2];
+    volatile int failures = 0;
+
+    // records without usage data, as the first releases wrote them
+    reset_metadatas();
+    uint32_t offset = 0;
+    for (size_t n = 0; offset < MAX_METADATAS * 3 / 4; n++) {
+        const char *nickname = churn_nickname(n);
+        uint8_t record[3 + MAX_METANAME];
+        size_t len = strlen(nickname);
+        record[0] = 1 + len;
+        record[1] = n % 5 == 4 ? META_ERASED : META_NONE;
+        record[2] = 0x0F;
+        memcpy(record + 3, nickname, len);
+        nvm_write((void *) METADATA_PTR(offset), record, 3 + len);
+        offset += 3 + len;
+    }
+    uint8_t legacy_version = 0;
+    nvm_write((void *) &N_storage.metadata_version, &legacy_version, 1);
+    list_nicknames(expected, sizeof(expected));
+    memcpy(&before, (const void *) &N_storage, sizeof(before));
+
+    volatile bool completed = false;
+    volatile unsigned int writes = 0;
+    while (!completed) {
+        memcpy((void *) &N_storage, &before, sizeof(before));
+        host_nvm_lose_power_after(++writes);
+        if (setjmp(G_nvm_power_loss) == 0) {
+            migrate_metadatas();
+            host_nvm_lose_power_after(0);
+            completed = true;
+        }
+        // the device restarts
+        recover_metadata();
+        migrate_metadatas();
+        check_metadatas(false);
+        bool current = N_storage.metadata_version == METADATA_VERSION;
+        for (uint32_t entry = metadata_first(); entry != METADATA_END;
+             entry = metadata_next(entry)) {
+            current = current && METADATA_FORMAT(entry) == META_EXTENDED &&
+                      METADATA_IS_CHECKED(entry);
+        }
+        list_nicknames(migrated, sizeof(migrated));
+        uint32_t digest = N_storage.metadata_digest;
+        if (!current || strcmp(migrated, expected) != 0 || check_metadatas(false) != 0 ||
+            N_storage.metadata_digest != digest) {
+            fprintf(stderr, "power loss at write %u of a migration: entries differ\n", writes);
+            failures++;
+        }
+    }
+    printf("\nmigration of legacy records: %u bytes before, %u after\n",
+           offset,
+           find_free_metadata());
+    printf("power loss at each of the %u writes of a migration: %d failures\n",
+           writes - 1,
+           failures);
+    return failures;
+}
+
+int main(void) {
+    int failures = check_round_trips();
+
+    nvm_write((void *) &N_storage, NULL, sizeof(N_storage));
+    reset_metadatas();
+    size_t entries = 0;
+    size_t plain_bytes = 0;
+    for (;; entries++) {
+        const char *nickname = NICKNAMES[entries % NICKNAMES_COUNT];
+        uint8_t data[1 + MAX_METANAME];
+        size_t len = strlen(nickname);
+        data[0] = 1 + entries / NICKNAMES_COUNT;
+        memcpy(data + 1, nickname, len);
+        if (write_metadata(data, 1 + len) != OK) {
+            break;
+        }
+        plain_bytes += 2 + 1 + len + METADATA_CHECKSUM_LEN + sizeof(metadata_ext_t);
+    }
+    size_t packed_bytes = find_free_metadata();
+
+    uint32_t offset = 0;
+    for (size_t n = 0; n < entries; n++) {
+        const char *nickname = NICKNAMES[n % NICKNAMES_COUNT];
+        char stored[MAX_METANAME + 1];
+        get_metadata_nickname(offset, stored);
+        if (strcmp(stored, nickname) != 0) {
+            fprintf(stderr, "entry %zu reads \"%s\" instead of \"%s\"\n", n, stored, nickname);
+            failures++;
+        }
+        offset += METADATA_TOTAL_LEN(offset);
+    }
+
+    double per_entry = (double) packed_bytes / entries;
+    double plain_per_entry = (double) plain_bytes / entries;
+    printf("nicknames   bytes/entry   entries/%d bytes\n", MAX_METADATAS);
+    printf("%-9s %13.2f %18.0f\n", "plain", plain_per_entry, MAX_METADATAS / plain_per_entry);
+    printf("%-9s %13.2f %18zu\n", "packed", per_entry, entries);
+    printf("%+.0f%% entries\n", 100.0 * (plain_per_entry / per_entry - 1));
+
+    printf("\ncompaction  page programs  programs/page  max/page  header page  full writes\n");
+    failures += churn("eager", COMPACT_EAGER);
+    failures += churn("lazy", COMPACT_WHEN_FULL);
+    failures += churn("idle", COMPACT_WHEN_IDLE);
+    failures += check_power_losses();
+    failures += check_reset();
+    failures += check_digest();
+    failures += check_loads();
+    failures += check_duplicates();
+    failures += check_group_change();
+    failures += check_stats();
+    failures += check_migrations();
+    return failures != 0;
+}
@@ -0,0 +1,8 @@
+#ifndef HOST_STUB_CX_H
+#define HOST_STUB_CX_H
+
+#include "os.h"
+
+int cx_hash_sha256(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef HOST_STUBS_H
+#define HOST_STUBS_H
+
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types.h"
+
+#define HID_REPORT_LENGTH   8
+#define MAX_CAPTURED_REPORTS 4096
+
+/* Every report handed to io_usb_send_ep() is appended here, in order. */
+extern uint8_t G_captured_reports[MAX_CAPTURED_REPORTS][HID_REPORT_LENGTH];
+extern size_t G_captured_count;
+
+void host_capture_reset(void);
+
+/* Each nvm_write() to the storage counts one program of every flash page it touches. */
+#define HOST_NVM_PAGE_SIZE 64
+#define HOST_NVM_PAGES     (sizeof(internalStorage_t) / HOST_NVM_PAGE_SIZE + 2)
+
+extern uint32_t G_nvm_page_programs[];
+
+void host_nvm_reset_counters(void);
+
+/* Simulated power loss: the nth nvm_write() from now only writes the first half of its data,
+ * then longjmp()s to G_nvm_power_loss; 0 disarms it. */
+extern jmp_buf G_nvm_power_loss;
+
+void host_nvm_lose_power_after(unsigned int writes);
+
+#endif
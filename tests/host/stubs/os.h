@@ -0,0 +1,60 @@
+/*
+ * Minimal host-side replacement for the BOLOS SDK "os.h", only covering what the
+ * typing, mapping and generation sources need to run on a development machine.
+ */
+#ifndef HOST_STUB_OS_H
+#define HOST_STUB_OS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PIC(x)                 ((void *) (x))
+#define os_memcpy              memcpy
+#define os_memmove             memmove
+#define os_memset              memset
+#define os_memcmp              memcmp
+#define PRINTF(...)
+#define U2BE(buf, off)         ((uint16_t) (((buf)[off] << 8) | (buf)[(off) + 1]))
+
+#define EXCEPTION         1
+#define INVALID_PARAMETER 2
+#define THROW(e)          host_throw(e, __FILE__, __LINE__)
+void host_throw(unsigned int e, const char *file, int line) __attribute__((noreturn));
+
+#define CX_CURVE_SECP256K1 0x21
+
+#define IO_USB_MAX_ENDPOINTS 4
+
+typedef struct {
+    struct {
+        unsigned short timeout;
+    } usb_ep_timeouts[IO_USB_MAX_ENDPOINTS];
+} io_app_t;
+
+extern io_app_t G_io_app;
+extern unsigned char G_io_seproxyhal_spi_buffer[300];
+
+unsigned char io_usb_send_ep(unsigned int ep,
+                             unsigned char *buffer,
+                             unsigned short length,
+                             unsigned int timeout);
+unsigned int io_seproxyhal_spi_is_status_sent(void);
+void io_seproxyhal_general_status(void);
+unsigned short io_seproxyhal_spi_recv(unsigned char *buffer,
+                                      unsigned short maxlength,
+                                      unsigned int flags);
+void io_seproxyhal_handle_event(void);
+
+#define BOLOS_UX_OK 0xAA
+unsigned int os_global_pin_is_validated(void);
+
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len);
+void os_perso_derive_node_bip32(unsigned int curve,
+                                const unsigned int *path,
+                                unsigned int pathLength,
+                                unsigned char *privateKey,
+                                unsigned char *chain);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef HOST_STUB_OS_IO_SEPROXYHAL_H
+#define HOST_STUB_OS_IO_SEPROXYHAL_H
+
+#include "os.h"
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Host implementations of the SDK services used by the typing path. The USB endpoint
+ * records reports instead of sending them, and the seed derivation is replaced by a
+ * deterministic mix: passwords differ from the device, but are stable between runs.
+ * Flash writes count the programs of each storage page, and can simulate a power loss.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "os.h"
+#include "cx.h"
+#include "host_stubs.h"
+#include "types.h"
+
+internalStorage_t N_storage_real;
+app_state_t app_state;
+volatile unsigned int G_led_status;
+io_app_t G_io_app;
+unsigned char G_io_seproxyhal_spi_buffer[300];
+
+uint8_t G_captured_reports[MAX_CAPTURED_REPORTS][HID_REPORT_LENGTH];
+size_t G_captured_count;
+
+uint32_t G_nvm_page_programs[HOST_NVM_PAGES];
+jmp_buf G_nvm_power_loss;
+
+static unsigned int writes_before_power_loss;
+
+void host_capture_reset(void) {
+    G_captured_count = 0;
+}
+
+void host_throw(unsigned int e, const char *file, int line) {
+    fprintf(stderr, "THROW(%u) at %s:%d\n", e, file, line);
+    exit(2);
+}
+
+unsigned char io_usb_send_ep(unsigned int ep,
+                             unsigned char *buffer,
+                             unsigned short length,
+                             unsigned int timeout) {
+    (void) ep;
+    (void) timeout;
+    if (G_captured_count >= MAX_CAPTURED_REPORTS || length != HID_REPORT_LENGTH) {
+        THROW(EXCEPTION);
+    }
+    memcpy(G_captured_reports[G_captured_count++], buffer, HID_REPORT_LENGTH);
+    return length;
+}
+
+unsigned int io_seproxyhal_spi_is_status_sent(void) {
+    return 1;
+}
+
+void io_seproxyhal_general_status(void) {
+}
+
+unsigned short io_seproxyhal_spi_recv(unsigned char *buffer,
+                                      unsigned short maxlength,
+                                      unsigned int flags) {
+    (void) buffer;
+    (void) maxlength;
+    (void) flags;
+    return 0;
+}
+
+void io_seproxyhal_handle_event(void) {
+}
+
+unsigned int os_global_pin_is_validated(void) {
+    return BOLOS_UX_OK;
+}
+
+void host_nvm_reset_counters(void) {
+    memset(G_nvm_page_programs, 0, sizeof(G_nvm_page_programs));
+}
+
+void host_nvm_lose_power_after(unsigned int writes) {
+    writes_before_power_loss = writes;
+}
+
+void nvm_write(void *dst_adr, void *src_adr, unsigned int src_len) {
+    if (writes_before_power_loss != 0 && --writes_before_power_loss == 0) {
+        if (src_adr == NULL) {
+            memset(dst_adr, 0, src_len / 2);
+        } else {
+            memmove(dst_adr, src_adr, src_len / 2);
+        }
+        longjmp(G_nvm_power_loss, 1);
+    }
+    uintptr_t base = (uintptr_t) &N_storage_real / HOST_NVM_PAGE_SIZE;
+    uintptr_t first = (uintptr_t) dst_adr / HOST_NVM_PAGE_SIZE;
+    uintptr_t last = ((uintptr_t) dst_adr + src_len - 1) / HOST_NVM_PAGE_SIZE;
+    for (uintptr_t page = first; src_len != 0 && page <= last; page++) {
+        if (page >= base && page - base < HOST_NVM_PAGES) {
+            G_nvm_page_programs[page - base]++;
+        }
+    }
+    if (src_adr == NULL) {
+        memset(dst_adr, 0, src_len);
+    } else {
+        memmove(dst_adr, src_adr, src_len);
+    }
+}
+
+/* FNV-1a based expansion, only meant to be deterministic */
+static void mix(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len) {
+    uint32_t h = 2166136261u;
+    for (unsigned int i = 0; i < len; i++) {
+        h = (h ^ in[i]) * 16777619u;
+    }
+    for (unsigned int i = 0; i < out_len; i++) {
+        h = (h ^ i) * 16777619u;
+        out[i] = h >> 24;
+    }
+}
+
+int cx_hash_sha256(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len) {
+    mix(in, len, out, out_len < 32 ? out_len : 32);
+    return 32;
+}
+
+void os_perso_derive_node_bip32(unsigned int curve,
+                                const unsigned int *path,
+                                unsigned int pathLength,
+                                unsigned char *privateKey,
+                                unsigned char *chain) {
+    (void) curve;
+    mix((const unsigned char *) path, pathLength * sizeof(*path), privateKey, 32);
+    if (chain != NULL) {
+        mix(privateKey, 32, chain, 32);
+    }
+}
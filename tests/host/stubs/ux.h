@@ -0,0 +1,10 @@
+/*
+ * Minimal host-side replacement for the BOLOS SDK "ux.h", only covering the types the headers
+ * of the command handlers name.
+ */
+#ifndef HOST_STUB_UX_H
+#define HOST_STUB_UX_H
+
+typedef struct bagl_element_s bagl_element_t;
+
+#endif
@@ -15,6 +15,9 @@ class InsType(enum.IntEnum):
     INS_GET_APP_CONFIG = 0x03
     INS_DUMP_METADATAS = 0x04
     INS_LOAD_METADATAS = 0x05
+    INS_TYPE_TEXT = 0x06
+    INS_GET_PASSWORD = 0x07
+    INS_GET_STORE_STATS = 0x08
     INS_RUN_TEST = 0x99
 
 
@@ -143,10 +146,67 @@ class PasswordsManagerCommand:
         if not sw & 0x9000:
             raise DeviceException(error_code=sw, ins=ins)
 
+        return response
+
     def load_metadatas(self, metadatas):
+        """Returns the number of duplicate entries erased after the load."""
 
         chunks = [metadatas[i:i+255] for i in range(0, len(metadatas), 255)]
 
         for i, chunk in enumerate(chunks):
             is_last_chunk = True if i+1 == len(chunks) else False
-            self.load_metadatas_chunk(chunk, is_last_chunk)
+            response = self.load_metadatas_chunk(chunk, is_last_chunk)
+
+        return int.from_bytes(response, byteorder="big")
+
+    def type_text(self, text: str, press_enter: bool = False):
+        ins: InsType = InsType.INS_TYPE_TEXT
+
+        self.transport.send(cla=CLA,
+                            ins=ins,
+                            p1=0x01 if press_enter else 0x00,
+                            p2=0x00,
+                            cdata=bytes(text, "ascii"))
+
+        sw, response = self.transport.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceException(error_code=sw, ins=ins)
+
+    def get_password(self, index: int) -> str:
+        ins: InsType = InsType.INS_GET_PASSWORD
+
+        self.transport.send(cla=CLA,
+                            ins=ins,
+                            p1=0x00,
+                            p2=0x00,
+                            cdata=index.to_bytes(2, "big"))
+
+        sw, response = self.transport.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceException(error_code=sw, ins=ins)
+
+        return response.decode("ascii")
+
+    def get_store_stats(self):
+        """Returns the entries count, the erased and free bytes, the fragmentation in per mille,
+        the compactions and the bytes written."""
+        ins: InsType = InsType.INS_GET_STORE_STATS
+
+        self.transport.send(cla=CLA,
+                            ins=ins,
+                            p1=0x00,
+                            p2=0x00,
+                            cdata=b"")
+
+        sw, response = self.transport.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceException(error_code=sw, ins=ins)
+
+        assert len(response) == 20
+
+        fields = [(0, 2), (2, 4), (6, 4), (10, 2), (12, 4), (16, 4)]
+        return tuple(int.from_bytes(response[start:start + size], "big")
+                     for start, size in fields)
@@ -26,3 +26,25 @@ def test_load_metadatas(cmd, test_vector):
     cmd.load_metadatas(metadatas)
     assert cmd.dump_metadatas(len(metadatas)) == metadatas
     cmd.reset_approval_state()
+
+
+def test_load_metadatas_with_duplicates(cmd, test_vector):
+    metadatas, duplicates, expected = test_vector
+    assert cmd.load_metadatas(metadatas) == duplicates
+    assert cmd.dump_metadatas(len(expected)) == expected
+    cmd.reset_approval_state()
+
+
+def test_get_store_stats(cmd, test_vector):
+    metadatas, expected = test_vector
+    cmd.load_metadatas(metadatas)
+    entries, erased, free, fragmentation, compactions, written = cmd.get_store_stats()
+    assert (entries, erased, free, fragmentation) == expected
+    assert written >= len(metadatas)
+
+
+def test_get_password(cmd, test_vector):
+    metadatas, index, expected = test_vector
+    cmd.load_metadatas(metadatas)
+    assert cmd.get_password(index) == expected
+    cmd.reset_approval_state()
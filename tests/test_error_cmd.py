@@ -50,7 +50,28 @@ def test_load_metadatas_with_too_much_data(cmd, test_vector):
     cmd.load_metadatas(metadatas)
 
 
+@pytest.mark.xfail(raises=MetadatasParsingError)
+def test_load_metadatas_with_bad_checksum(cmd, test_vector):
+    metadatas = test_vector
+    cmd.load_metadatas(metadatas)
+
+
 @pytest.mark.xfail(raises=MetadatasParsingError)
 def test_load_metadatas_with_name_too_long(cmd, test_vector):
     metadatas = test_vector
     cmd.load_metadatas(metadatas)
+
+
+@pytest.mark.xfail(raises=WrongDataLengthError)
+def test_type_text_too_long(cmd):
+    cmd.type_text("a" * 65)
+
+
+@pytest.mark.xfail(raises=WrongDataError)
+def test_type_text_not_printable(cmd):
+    cmd.type_text("user\tpassword")
+
+
+@pytest.mark.xfail(raises=EntryNotFoundError)
+def test_get_password_of_missing_entry(cmd):
+    cmd.get_password(0)
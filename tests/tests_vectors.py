@@ -23,6 +23,34 @@ tests_vectors = {
         bytes.fromhex("02000761060007616c6c6168") + b"\x00" * (4096 - 12),
         bytes.fromhex("02000761" "14 00 07 616c6c6168616c6c6168616c6c6168616c6c70") +
         b"\x00" * (4096 - 26),
+        # tagged record: sets, nickname, group 3, usage data
+        bytes.fromhex("02000761" "0b 02 07 676d61696c 03 00010002") + b"\x00" * (4096 - 17),
+        # packed record: sets, "gmail.com" packed in 3 bytes, usage data
+        bytes.fromhex("02000761" "08 11 07 1b2a7f 00000000") + b"\x00" * (4096 - 14),
+        # checked record: sets, "gmail" packed, CRC-8 of the length, sets and nickname
+        bytes.fromhex("02000761" "08 31 07 1b2f ab 00000000") + b"\x00" * (4096 - 14),
+    ],
+
+    # the same nickname with other charsets is not a duplicate, the later copy is erased
+    "test_load_metadatas_with_duplicates": [
+        [bytes.fromhex("02000761" "060007616c6c6168" "02000161" "02000761"), 1,
+         bytes.fromhex("02000761" "060007616c6c6168" "02000161" "02ff0761")],
+    ],
+
+    # entries, erased bytes, free bytes, fragmentation (per mille)
+    "test_get_store_stats": [
+        [bytes.fromhex("02000761" "060007616c6c6168"), (2, 0, 4096 - 12, 0)],
+        # the duplicate is erased after the load
+        [bytes.fromhex("02000761" "060007616c6c6168" "02000761"), (2, 4, 4096 - 16, 0)],
+    ],
+
+    "test_get_password": [
+        [bytes.fromhex("06000767" "6d61696c"), 0, "xNX8IQO4vP0ucO41J6JW"],
+        [bytes.fromhex("060007616c6c6168" "06 00 03 676d61696c"), 1, "KqIJcPjhENivHvOdmuKQ"],
+        [bytes.fromhex("0b020767" "6d61696c" "03" "00000000"), 0, "xNX8IQO4vP0ucO41J6JW"],
+        # "gmail" packed, the password is derived from the unpacked nickname
+        [bytes.fromhex("071107" "1b2f" "00000000"), 0, "xNX8IQO4vP0ucO41J6JW"],
+        [bytes.fromhex("083107" "1b2f" "ab" "00000000"), 0, "xNX8IQO4vP0ucO41J6JW"],
     ],
 
     "test_load_metadatas_with_too_much_data": [
@@ -30,6 +58,10 @@ tests_vectors = {
         bytes.fromhex("02000761060007616c6c6168") + b"\x00" * 4096,
     ],
 
+    "test_load_metadatas_with_bad_checksum": [
+        bytes.fromhex("02000761" "08 31 07 1b2f ac 00000000"),
+    ],
+
     "test_load_metadatas_with_name_too_long": [
         bytes.fromhex(
             "02000761" "15 00 07 616c6c6168616c6c6168616c6c6168616c6c7078"),
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Generates src/domain_trie_data.c, the built-in dictionary used to complete nicknames.
+
+The words are stored as a radix tree serialized depth first:
+
+    node := header edge*
+    header := terminal flag (0x80) | number of edges (7 bits)
+    edge := label | subtree length | node
+
+The last character of a label has its bit 7 set, and the common endings in SUFFIX_TOKENS
+are replaced by a single control character. The subtree length takes one byte below 0x80,
+two bytes (big endian, bit 15 set) above. A length of 0 stands for a terminal node without
+edges, which is then omitted.
+
+Edges are sorted by the rank of the most popular word below them, so following the first
+edge of each node from a prefix gives its most popular completion.
+
+    python3 tools/gen_domain_trie.py > src/domain_trie_data.c
+"""
+
+# must match DOMAIN_TRIE_TOKENS in src/domain_trie.c
+SUFFIX_TOKENS = [".com", ".org", ".net"]
+
+# most popular first
+WORDS = [
+    ".com", ".org", ".net", ".io", ".fr", ".de", ".co.uk", ".ch", ".eu", ".dev", ".app",
+    "google.com", "gmail.com", "github.com", "facebook.com", "amazon.com", "apple.com",
+    "microsoft.com", "outlook.com", "live.com", "hotmail.com", "yahoo.com", "twitter.com",
+    "linkedin.com", "instagram.com", "netflix.com", "paypal.com", "dropbox.com", "reddit.com",
+    "wikipedia.org", "icloud.com", "protonmail.com", "proton.me", "gitlab.com",
+    "bitbucket.org", "stackoverflow.com", "slack.com", "discord.com", "spotify.com",
+    "ebay.com", "youtube.com", "twitch.tv", "zoom.us", "steampowered.com", "adobe.com",
+    "atlassian.com", "digitalocean.com", "cloudflare.com", "heroku.com", "godaddy.com",
+    "namecheap.com", "ovh.com", "airbnb.com", "booking.com", "uber.com", "whatsapp.com",
+    "telegram.org", "signal.org", "mozilla.org", "binance.com", "coinbase.com", "kraken.com",
+    "ledger.com", "bitstamp.net", "aws.amazon.com", "azure.com", "docker.com", "npmjs.com",
+    "pypi.org", "medium.com", "pinterest.com", "tumblr.com", "wordpress.com", "shopify.com",
+    "stripe.com", "revolut.com", "wise.com", "n26.com", "gandi.net", "fastmail.com",
+    "tutanota.com", "duckduckgo.com", "bing.com", "office.com", "skype.com",
+    "nintendo.com", "playstation.com", "xbox.com", "epicgames.com", "origin.com",
+]
+
+
+def build(words):
+    # DOMAIN_TRIE_MAX_WORD in src/domain_trie.h
+    assert all(len(word) < 32 for word in words)
+    root = {"terminal": False, "children": {}, "rank": len(words)}
+    for rank, word in enumerate(words):
+        node = root
+        node["rank"] = min(node["rank"], rank)
+        for c in word:
+            node = node["children"].setdefault(c, {"terminal": False, "children": {},
+                                                   "rank": rank})
+            node["rank"] = min(node["rank"], rank)
+        node["terminal"] = True
+    return root
+
+
+def encode_label(label):
+    for token, suffix in enumerate(SUFFIX_TOKENS, start=1):
+        label = label.replace(suffix, chr(token))
+    data = bytearray(label.encode())
+    assert all(c < 0x80 for c in data)
+    data[-1] |= 0x80
+    return bytes(data)
+
+
+def encode_length(length):
+    if length < 0x80:
+        return bytes([length])
+    assert length < 0x8000
+    return (0x8000 | length).to_bytes(2, "big")
+
+
+def serialize(node):
+    edges = []
+    for c, child in sorted(node["children"].items(), key=lambda item: item[1]["rank"]):
+        label = c
+        # merge the chains of single child nodes into the edge label
+        while not child["terminal"] and len(child["children"]) == 1:
+            (c, child), = child["children"].items()
+            label += c
+        if child["terminal"] and not child["children"]:
+            edges.append(encode_label(label) + encode_length(0))
+        else:
+            subtree = serialize(child)
+            edges.append(encode_label(label) + encode_length(len(subtree)) + subtree)
+    assert len(edges) < 128
+    return bytes([(0x80 if node["terminal"] else 0) | len(edges)]) + b"".join(edges)
+
+
+def main():
+    data = serialize(build(WORDS))
+    print("/*")
+    print(" * Generated by tools/gen_domain_trie.py, do not edit.")
+    print(" * %d words, %d bytes of text in %d bytes." %
+          (len(WORDS), sum(len(w) for w in WORDS), len(data)))
+    print(" */")
+    print()
+    print('#include "domain_trie.h"')
+    print()
+    print("const uint8_t DOMAIN_TRIE[] = {")
+    for i in range(0, len(data), 12):
+        print("    " + " ".join("0x%02x," % b for b in data[i:i + 12]))
+    print("};")
+    print()
+    print("const uint16_t DOMAIN_TRIE_SIZE = sizeof(DOMAIN_TRIE);")
+
+
+if __name__ == "__main__":
+    main()